@@ -0,0 +1,354 @@
+/**
+ * @file prt7_bench.cpp
+ * @brief Banco de pruebas de rendimiento del decodificador PRT-7
+ * @author Sistema de Ciberseguridad Industrial
+ * @date 2025
+ * * Mide las operaciones del núcleo (rotar, getMapeo, traducción en bloque,
+ * insertarAlFinal, análisis de tramas, puntos de control), la
+ * decodificación completa de flujos sintéticos y la API por empuje
+ * (DecodificadorPRT7) con Google Benchmark. Antes de medir solo comprueba
+ * que los dos motores de rotor den el mismo mapeo, para no medir un motor
+ * roto; las pruebas de corrección están en tests/prt7_pruebas.cpp (ctest).
+ *
+ * Opción propia: `--prt7_max_tramas=N` (por defecto 1000000) limita el
+ * tamaño máximo del flujo sintético; usar 100000000 para la serie completa.
+ */
+
+#include "decodificador_prt7.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+
+long long maxTramas = 1000000;
+
+/**
+ * @brief Generador congruencial lineal determinista
+ */
+struct Aleatorio {
+    unsigned long long estado;
+    
+    Aleatorio(unsigned long long semilla) : estado(semilla) {}
+    
+    unsigned int siguiente() {
+        estado = estado * 6364136223846793005ULL + 1442695040888963407ULL;
+        return (unsigned int)(estado >> 33);
+    }
+};
+
+/**
+ * @brief Genera un flujo PRT-7 con la mezcla típica de LOAD/MAP
+ * * Aproximadamente 1 de cada 8 tramas es MAP (rotaciones en [-30, 30]) y
+ * 1 de cada 16 LOAD es un espacio ("L,Space").
+ */
+std::string generarFlujo(long long tramas) {
+    std::string flujo;
+    flujo.reserve((size_t)tramas * 6 + 32);
+    flujo += "SISTEMA PRT-7 ACTIVO\r\n";
+    
+    Aleatorio aleatorio(7);
+    char linea[16];
+    
+    for (long long i = 0; i < tramas; i++) {
+        unsigned int r = aleatorio.siguiente();
+        
+        if (r % 8 == 0) {
+            int n = (int)(r / 8 % 61) - 30;
+            std::snprintf(linea, sizeof(linea), "M,%d\r\n", n);
+            flujo += linea;
+        } else if (r % 16 == 1) {
+            flujo += "L,Space\r\n";
+        } else {
+            flujo += "L,";
+            flujo += (char)('A' + r / 16 % 26);
+            flujo += "\r\n";
+        }
+    }
+    
+    flujo += "FIN\r\n";
+    return flujo;
+}
+
+/**
+ * @brief Flujo sintético por tamaño, generado una sola vez
+ */
+const std::string& flujoDeTamanio(long long tramas) {
+    static std::vector<std::pair<long long, std::string> > cache;
+    
+    for (size_t i = 0; i < cache.size(); i++) {
+        if (cache[i].first == tramas) return cache[i].second;
+    }
+    
+    cache.push_back(std::make_pair(tramas, generarFlujo(tramas)));
+    return cache.back().second;
+}
+
+/**
+ * @brief Comprueba que RotorEnlazado y RotorIndexado sean equivalentes
+ * @return true si ambos producen el mismo mapeo en todos los pasos
+ */
+bool verificarRotores() {
+    RotorEnlazado enlazado;
+    RotorIndexado indexado;
+    Aleatorio aleatorio(42);
+    
+    for (int paso = 0; paso < 20000; paso++) {
+        int n = (int)(aleatorio.siguiente() % 2001) - 1000;
+        enlazado.rotar(n);
+        indexado.rotar(n);
+        
+        if (enlazado.getCabeza() != indexado.getCabeza()) return false;
+        
+        for (int c = 0; c < 256; c++) {
+            if (enlazado.getMapeo((char)c) != indexado.getMapeo((char)c)) return false;
+        }
+    }
+    
+    return true;
+}
+
+typedef CascadaDeRotores<AlfabetoMayusculas, 3> CascadaDeTres;
+
+template <typename Rotor>
+void BM_Rotar(benchmark::State& state) {
+    Rotor rotor;
+    int n = (int)state.range(0);
+    
+    for (auto _ : state) {
+        rotor.rotar(n);
+        benchmark::DoNotOptimize(rotor.getCabeza());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(BM_Rotar, RotorEnlazado)->Arg(1)->Arg(13)->Arg(25)->Arg(-7)->Arg(1000003);
+BENCHMARK_TEMPLATE(BM_Rotar, RotorIndexado)->Arg(1)->Arg(13)->Arg(25)->Arg(-7)->Arg(1000003);
+BENCHMARK_TEMPLATE(BM_Rotar, RotorAlfanumerico)->Arg(1)->Arg(13)->Arg(25)->Arg(-7)->Arg(1000003);
+BENCHMARK_TEMPLATE(BM_Rotar, RotorDeBytes)->Arg(1)->Arg(13)->Arg(25)->Arg(-7)->Arg(1000003);
+BENCHMARK_TEMPLATE(BM_Rotar, CascadaDeTres)->Arg(1)->Arg(13)->Arg(25)->Arg(-7)->Arg(1000003);
+
+template <typename Rotor>
+void BM_GetMapeo(benchmark::State& state) {
+    Rotor rotor;
+    rotor.rotar(5);
+    char entrada[26];
+    for (int i = 0; i < 26; i++) entrada[i] = (char)('A' + i);
+    
+    for (auto _ : state) {
+        for (int i = 0; i < 26; i++) {
+            benchmark::DoNotOptimize(rotor.getMapeo(entrada[i]));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * 26);
+}
+BENCHMARK_TEMPLATE(BM_GetMapeo, RotorEnlazado);
+BENCHMARK_TEMPLATE(BM_GetMapeo, RotorIndexado);
+BENCHMARK_TEMPLATE(BM_GetMapeo, RotorAlfanumerico);
+BENCHMARK_TEMPLATE(BM_GetMapeo, RotorDeBytes);
+BENCHMARK_TEMPLATE(BM_GetMapeo, CascadaDeTres);
+
+template <typename Rotor>
+void BM_TraducirBloque(benchmark::State& state) {
+    Rotor rotor;
+    rotor.rotar(11);
+    std::vector<char> bloque((size_t)state.range(0));
+    for (size_t i = 0; i < bloque.size(); i++) {
+        bloque[i] = (i % 16 == 0) ? ' ' : (char)('A' + i % 26);
+    }
+    
+    for (auto _ : state) {
+        traducirBloque(rotor, bloque.data(), (int)bloque.size());
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_TEMPLATE(BM_TraducirBloque, RotorEnlazado)->Arg(512)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_TraducirBloque, RotorIndexado)->Arg(512)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_TraducirBloque, RotorAlfanumerico)->Arg(512)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_TraducirBloque, RotorDeBytes)->Arg(512)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_TraducirBloque, CascadaDeTres)->Arg(512)->Arg(1 << 16);
+
+void BM_InsertarAlFinal(benchmark::State& state) {
+    long long cantidad = state.range(0);
+    
+    for (auto _ : state) {
+        ListaDeCarga carga(IMPRESION_SILENCIOSA);
+        for (long long i = 0; i < cantidad; i++) {
+            carga.insertarAlFinal((char)('A' + i % 26));
+        }
+        benchmark::DoNotOptimize(carga.getTamanio());
+    }
+    state.SetItemsProcessed(state.iterations() * cantidad);
+}
+BENCHMARK(BM_InsertarAlFinal)->RangeMultiplier(16)->Range(1 << 10, 1 << 22);
+
+void BM_CopiarMensaje(benchmark::State& state) {
+    int cantidad = (int)state.range(0);
+    ListaDeCarga carga(IMPRESION_SILENCIOSA);
+    for (int i = 0; i < cantidad; i++) {
+        carga.insertarAlFinal((char)('A' + i % 26));
+    }
+    std::vector<char> destino((size_t)cantidad);
+    
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(carga.copiarEn(destino.data(), cantidad));
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * cantidad);
+}
+BENCHMARK(BM_CopiarMensaje)->RangeMultiplier(16)->Range(1 << 10, 1 << 22);
+
+void BM_RestaurarPuntoDeControl(benchmark::State& state) {
+    int cantidad = (int)state.range(0);
+    ListaDeCarga carga(IMPRESION_SILENCIOSA);
+    for (int i = 0; i < cantidad; i++) {
+        carga.insertarAlFinal((char)('A' + i % 26));
+    }
+    RotorIndexado rotor;
+    rotor.rotar(7);
+    EstadoDeFlujo estado;
+    std::vector<char> imagen((size_t)tamanioPuntoDeControl<RotorIndexado>(carga));
+    int longitud = serializarPuntoDeControl(carga, rotor, estado, imagen.data(), (int)imagen.size());
+    
+    ListaDeCarga restaurada(IMPRESION_SILENCIOSA);
+    RotorIndexado otroRotor;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(restaurarPuntoDeControl(imagen.data(), longitud, restaurada, otroRotor, estado));
+    }
+    state.SetBytesProcessed(state.iterations() * longitud);
+}
+BENCHMARK(BM_RestaurarPuntoDeControl)->RangeMultiplier(16)->Range(1 << 6, 1 << 16);
+
+/**
+ * @brief Líneas representativas para medir el análisis de tramas
+ */
+char lineasDePrueba[][12] = {"L,H", "L,Space", "M,5", "M,-12", "L,Z", "M,+3", "X,1", "L,A"};
+const int CANTIDAD_LINEAS = sizeof(lineasDePrueba) / sizeof(lineasDePrueba[0]);
+
+void BM_ParsearTrama(benchmark::State& state) {
+    for (auto _ : state) {
+        for (int i = 0; i < CANTIDAD_LINEAS; i++) {
+            TramaBase* trama = parsearTrama(lineasDePrueba[i]);
+            benchmark::DoNotOptimize(trama);
+            delete trama;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * CANTIDAD_LINEAS);
+}
+BENCHMARK(BM_ParsearTrama);
+
+void BM_AnalizarTrama(benchmark::State& state) {
+    int longitudes[CANTIDAD_LINEAS];
+    for (int i = 0; i < CANTIDAD_LINEAS; i++) {
+        longitudes[i] = (int)std::strlen(lineasDePrueba[i]);
+    }
+    Trama trama;
+    
+    for (auto _ : state) {
+        for (int i = 0; i < CANTIDAD_LINEAS; i++) {
+            benchmark::DoNotOptimize(analizarTrama(lineasDePrueba[i], longitudes[i], trama));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * CANTIDAD_LINEAS);
+}
+BENCHMARK(BM_AnalizarTrama);
+
+template <typename Rotor>
+void BM_DecodificacionCompleta(benchmark::State& state) {
+    const std::string& flujo = flujoDeTamanio(state.range(0));
+    
+    for (auto _ : state) {
+        ListaDeCarga carga(IMPRESION_SILENCIOSA);
+        Rotor rotor;
+        EstadisticasLote stats = decodificarLote(flujo.data(), flujo.size(), carga, rotor);
+        benchmark::DoNotOptimize(stats.tramasLoad);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(state.iterations() * (long long)flujo.size());
+}
+
+void BM_DecodificacionParalela(benchmark::State& state) {
+    const std::string& flujo = flujoDeTamanio(state.range(0));
+    
+    for (auto _ : state) {
+        ListaDeCarga carga(IMPRESION_SILENCIOSA);
+        RotorIndexado rotor;
+        EstadisticasLote stats = decodificarParalelo(flujo.data(), flujo.size(), carga, rotor, 0);
+        benchmark::DoNotOptimize(stats.tramasLoad);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(state.iterations() * (long long)flujo.size());
+}
+
+/**
+ * @brief Decodificación por empuje: el flujo llega en bloques de 1 KiB
+ */
+void BM_Alimentar(benchmark::State& state) {
+    const std::string& flujo = flujoDeTamanio(state.range(0));
+    static const int BLOQUE = 1024;
+    
+    for (auto _ : state) {
+        DecodificadorPRT7 decodificador;
+        long long eventos = 0;
+        
+        for (size_t pos = 0; pos < flujo.size(); pos += BLOQUE) {
+            int n = (int)(flujo.size() - pos < (size_t)BLOQUE ? flujo.size() - pos : BLOQUE);
+            eventos += decodificador.alimentar(flujo.data() + pos, n, [](const EventoPRT7&) {});
+        }
+        benchmark::DoNotOptimize(eventos);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(state.iterations() * (long long)flujo.size());
+}
+
+/**
+ * @brief Registra la decodificación completa de 1K hasta maxTramas tramas
+ */
+void registrarDecodificacionCompleta() {
+    for (long long n = 1000; n <= maxTramas; n *= 10) {
+        benchmark::RegisterBenchmark("BM_DecodificacionParalela", BM_DecodificacionParalela)
+            ->Arg(n)->Unit(benchmark::kMillisecond)->UseRealTime();
+        benchmark::RegisterBenchmark("BM_DecodificacionCompleta<RotorEnlazado>",
+                                     BM_DecodificacionCompleta<RotorEnlazado>)
+            ->Arg(n)->Unit(benchmark::kMillisecond);
+        benchmark::RegisterBenchmark("BM_DecodificacionCompleta<RotorIndexado>",
+                                     BM_DecodificacionCompleta<RotorIndexado>)
+            ->Arg(n)->Unit(benchmark::kMillisecond);
+        benchmark::RegisterBenchmark("BM_Alimentar", BM_Alimentar)
+            ->Arg(n)->Unit(benchmark::kMillisecond);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    // Extraer la opción propia antes de pasarle el resto a Google Benchmark
+    int restantes = 1;
+    for (int i = 1; i < argc; i++) {
+        const char* prefijo = "--prt7_max_tramas=";
+        if (std::strncmp(argv[i], prefijo, std::strlen(prefijo)) == 0) {
+            maxTramas = std::atoll(argv[i] + std::strlen(prefijo));
+        } else {
+            argv[restantes++] = argv[i];
+        }
+    }
+    argc = restantes;
+    
+    if (!verificarRotores()) {
+        std::fprintf(stderr, "ERROR: RotorEnlazado y RotorIndexado difieren.\n");
+        return 1;
+    }
+    std::printf("Verificacion de rotores: RotorEnlazado == RotorIndexado\n");
+    
+    registrarDecodificacionCompleta();
+    
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
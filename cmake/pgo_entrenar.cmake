@@ -0,0 +1,62 @@
+# Carga de entrenamiento para PGO (objetivo pgo_entrenar, con PRT7_PGO=GENERAR)
+#
+# Reproduce tráfico sintético con los modos de decodificación de producción
+# (secuencial, --tuberia, --mmap con y sin hilos) y corre el banco de
+# pruebas con un tiempo mínimo corto. Con Clang, además, une los perfiles
+# crudos en prt7.profdata.
+#
+# Variables: DECODIFICADOR, GENERADOR, BANCO (puede estar vacía), PERFILES,
+# COMPILADOR y LLVM_PROFDATA.
+
+if(NOT GENERADOR)
+    message(FATAL_ERROR "pgo_entrenar necesita prt7_generador (PRT7_HERRAMIENTAS=ON)")
+endif()
+
+file(MAKE_DIRECTORY "${PERFILES}")
+set(CICLOS "${PERFILES}/entrenamiento_ciclos.txt")
+set(LARGO "${PERFILES}/entrenamiento_largo.txt")
+set(SALIDA "${PERFILES}/entrenamiento_salida.txt")
+
+function(correr descripcion)
+    message(STATUS "PGO: ${descripcion}")
+    execute_process(COMMAND ${ARGN}
+        RESULT_VARIABLE codigo
+        OUTPUT_FILE "${SALIDA}"
+        ERROR_FILE "${SALIDA}.err"
+    )
+    if(NOT codigo EQUAL 0)
+        message(FATAL_ERROR "PGO: falló '${descripcion}' (código ${codigo}), ver ${SALIDA}.err")
+    endif()
+endfunction()
+
+correr("generando tráfico"
+       "${GENERADOR}" --salida "${CICLOS}" --ciclos 20000 --malformadas 2 --espacios 8)
+correr("generando un mensaje largo"
+       "${GENERADOR}" --salida "${LARGO}" --ciclos 1 --tramas 2000000 --rotacion-max 100000 --semilla 7)
+
+correr("decodificación secuencial"
+       "${DECODIFICADOR}" --archivo "${CICLOS}" --continuo --verbosidad silencio)
+correr("decodificación en tubería"
+       "${DECODIFICADOR}" --archivo "${CICLOS}" --continuo --verbosidad silencio --tuberia)
+correr("decodificación con salida por trama"
+       "${DECODIFICADOR}" --archivo "${CICLOS}" --continuo --incremental)
+correr("archivo mapeado"
+       "${DECODIFICADOR}" --mmap "${CICLOS}" --continuo --verbosidad silencio)
+correr("archivo mapeado en paralelo"
+       "${DECODIFICADOR}" --mmap "${LARGO}" --hilos 4 --verbosidad resumen)
+
+if(BANCO)
+    correr("banco de pruebas"
+           "${BANCO}" --benchmark_min_time=0.05 --prt7_max_tramas=100000)
+endif()
+
+if(COMPILADOR MATCHES "Clang")
+    if(NOT LLVM_PROFDATA)
+        message(FATAL_ERROR "PGO con Clang necesita llvm-profdata para unir los perfiles")
+    endif()
+    file(GLOB crudos "${PERFILES}/*.profraw")
+    correr("uniendo perfiles" "${LLVM_PROFDATA}" merge -output=${PERFILES}/prt7.profdata ${crudos})
+endif()
+
+file(REMOVE "${CICLOS}" "${LARGO}" "${SALIDA}" "${SALIDA}.err")
+message(STATUS "PGO: perfiles listos en ${PERFILES}; reconfigurar con PRT7_PGO=USAR")
@@ -8,7 +8,13 @@
  * un sistema de rotación de mapeo circular.
  */
 
+#include "decodificador_prt7.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
 #include <iostream>
+#include <thread>
 
 #ifdef _WIN32
     #include <windows.h>
@@ -16,354 +22,142 @@
     #include <fcntl.h>
     #include <unistd.h>
     #include <termios.h>
-    #include <cstring>
+    #include <sys/ioctl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <poll.h>
+    #include <cerrno>
+    #include <csignal>
+    #ifdef __linux__
+        #include <linux/serial.h>
+    #endif
 #endif
+#include <cstring>
 /**
- * @brief Nodo para la lista circular del rotor de mapeo
- */
-struct NodoRotor {
-    char dato;
-    NodoRotor* siguiente;
-    NodoRotor* previo;
-    
-    NodoRotor(char c) : dato(c), siguiente(nullptr), previo(nullptr) {}
-};
-/**
- * @brief Nodo para la lista doblemente enlazada de caracteres decodificados
+ * @brief Tiempo máximo que una lectura del puerto espera datos (ms)
+ * * La lectura despierta en cuanto llega el primer byte; este límite solo
+ * acota cuánto se bloquea un puerto inactivo.
  */
-struct NodoCarga {
-    char dato;
-    NodoCarga* siguiente;
-    NodoCarga* previo;
-    
-    NodoCarga(char c) : dato(c), siguiente(nullptr), previo(nullptr) {}
-};
-class ListaDeCarga;
-class RotorDeMapeo;
+const int TIMEOUT_LECTURA_MS = 1000;
+
 /**
- * @brief Clase base abstracta para todas las tramas del protocolo PRT-7
+ * @brief Tamaño de la cola de entrada del sistema para un puerto serial
+ * * Es el buffer de línea de Linux (N_TTY_BUF_SIZE); en Windows se pide el
+ * mismo tamaño con SetupComm().
  */
-class TramaBase {
-public:
-    /**
-     * @brief Método virtual puro para procesar la trama
-     * @param carga Puntero a la lista de carga donde se almacenan caracteres
-     * @param rotor Puntero al rotor de mapeo circular
-     */
-    virtual void procesar(ListaDeCarga*, RotorDeMapeo* rotor) = 0;
-    
-    /**
-     * @brief Destructor virtual obligatorio para limpieza polimórfica
-     */
-    virtual ~TramaBase() {}
-};
+const int CAPACIDAD_COLA_ENTRADA = 4096;
+
 /**
- * @brief Implementación del rotor de mapeo circular
- * * Actúa como un "disco de cifrado" que contiene el alfabeto (A-Z)
- * y puede rotar para cambiar el mapeo de caracteres.
+ * @brief Control de flujo con el que se frena al emisor (--flujo)
  */
-class RotorDeMapeo {
-private:
-    NodoRotor* cabeza;
-    int tamanio;
-    
-public:
-    /**
-     * @brief Constructor que inicializa el rotor con A-Z
-     */
-    RotorDeMapeo() : cabeza(nullptr), tamanio(0) {
-        // Crear lista circular con A-Z
-        const char* alfabeto = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
-        NodoRotor* primero = nullptr;
-        NodoRotor* anterior = nullptr;
-        
-        for (int i = 0; alfabeto[i] != '\0'; i++) {
-            NodoRotor* nuevo = new NodoRotor(alfabeto[i]);
-            
-            if (primero == nullptr) {
-                primero = nuevo;
-                cabeza = nuevo;
-            }
-            
-            if (anterior != nullptr) {
-                anterior->siguiente = nuevo;
-                nuevo->previo = anterior;
-            }
-            
-            anterior = nuevo;
-            tamanio++;
-        }
-        
-        // Cerrar el círculo
-        if (anterior != nullptr && primero != nullptr) {
-            anterior->siguiente = primero;
-            primero->previo = anterior;
-        }
-    }
-    
-    /**
-     * @brief Destructor que libera toda la memoria del rotor
-     */
-    ~RotorDeMapeo() {
-        if (cabeza == nullptr) return;
-        
-        NodoRotor* actual = cabeza;
-        NodoRotor* siguiente;
-        
-        // Romper el círculo
-        cabeza->previo->siguiente = nullptr;
-        
-        while (actual != nullptr) {
-            siguiente = actual->siguiente;
-            delete actual;
-            actual = siguiente;
-        }
-    }
-    
-    /**
-     * @brief Rota el rotor N posiciones (Versión Eficiente)
-     * @param n Número de posiciones a rotar (positivo o negativo)
-     */
-    void rotar(int n) {
-        if (cabeza == nullptr || tamanio == 0) return;
-        
-        // Normalizar n al rango del tamaño
-        int pasos = n % tamanio;
-        
-        if (pasos > 0) {
-            // Rotar hacia adelante
-            for (int i = 0; i < pasos; i++) {
-                cabeza = cabeza->siguiente;
-            }
-        } else if (pasos < 0) {
-            // Rotar hacia atrás
-            for (int i = 0; i < -pasos; i++) {
-                cabeza = cabeza->previo;
-            }
-        }
-        // Si pasos == 0, no hacer nada
-    }
-    
-    /**
-     * @brief Obtiene el mapeo de un carácter según la rotación actual
-     * @param in Carácter de entrada
-     * @return Carácter mapeado según la posición del rotor
-     */
-    char getMapeo(char in) {
-        // Si no es letra mayúscula, retornar sin cambios
-        if (in < 'A' || in > 'Z') {
-            return in;
-        }
-        
-        // 1. Calcular la posición alfabética absoluta (A=0, B=1, ...)
-        int posicion = in - 'A';
-        
-        // 2. Iniciar en la cabeza actual del rotor
-        NodoRotor* actual = cabeza;
-        
-        // 3. Avanzar 'posicion' pasos desde la cabeza
-        for (int i = 0; i < posicion; i++) {
-            actual = actual->siguiente;
-        }
-        
-        // 4. Devolver el carácter en esa nueva posición
-        return actual->dato;
-    }
-    
-    /**
-     * @brief Obtiene el carácter actual de la cabeza (posición 'A')
-     */
-    char getCabeza() const {
-        return cabeza ? cabeza->dato : 'A';
-    }
+enum ControlDeFlujo {
+    FLUJO_NINGUNO,      ///< Sin control: si el decodificador se atrasa, se pierden bytes
+    FLUJO_RTSCTS,       ///< Por hardware, con las líneas RTS/CTS
+    FLUJO_XONXOFF       ///< Por software, enviando XOFF/XON al emisor
 };
+
 /**
- * @brief Lista doblemente enlazada para almacenar caracteres decodificados
+ * @brief Parámetros con los que se abre un puerto serial
+ * * Se llenan desde la línea de comandos (--baudios, --timeout, --flujo) o
+ * desde un archivo de configuración (--config); los valores por omisión son
+ * los del sketch original de arduino.txt.
  */
-class ListaDeCarga {
-private:
-    NodoCarga* cabeza;
-    NodoCarga* cola;
-    int tamanio;
-    
-public:
-    /**
-     * @brief Constructor que inicializa una lista vacía
-     */
-    ListaDeCarga() : cabeza(nullptr), cola(nullptr), tamanio(0) {}
+struct ConfiguracionPuerto {
+    static const int MAX_RUTA = 256;
     
-    /**
-     * @brief Destructor que libera toda la memoria
-     */
-    ~ListaDeCarga() {
-        NodoCarga* actual = cabeza;
-        while (actual != nullptr) {
-            NodoCarga* siguiente = actual->siguiente;
-            delete actual;
-            actual = siguiente;
-        }
-    }
+    char dispositivo[MAX_RUTA]; ///< Puerto leído de --config ("" = ninguno)
+    int baudios;                ///< Velocidad en baudios
+    int timeoutMs;              ///< Espera máxima de una lectura
+    ControlDeFlujo flujo;       ///< Cómo se frena al emisor
     
-    /**
-     * @brief Inserta un carácter al final de la lista
-     * @param dato Carácter a insertar
-     */
-    void insertarAlFinal(char dato) {
-        NodoCarga* nuevo = new NodoCarga(dato);
-        
-        if (cabeza == nullptr) {
-            cabeza = cola = nuevo;
-        } else {
-            cola->siguiente = nuevo;
-            nuevo->previo = cola;
-            cola = nuevo;
-        }
-        
-        tamanio++;
+    ConfiguracionPuerto() : baudios(9600), timeoutMs(TIMEOUT_LECTURA_MS), flujo(FLUJO_NINGUNO) {
+        dispositivo[0] = '\0';
     }
     
     /**
-     * @brief Imprime el mensaje completo almacenado
+     * @brief Ocupación de la cola de entrada a partir de la cual se frena al emisor
+     * * Deja libres los bytes que alcanzan a llegar en unos 20 ms a la
+     * velocidad configurada (10 bits por byte): lo que tarda el emisor, o
+     * el adaptador USB, en reaccionar a la pausa sin desbordar la cola.
      */
-    void imprimirMensaje() const {
-        NodoCarga* actual = cabeza;
-        while (actual != nullptr) {
-            std::cout << actual->dato;
-            actual = actual->siguiente;
-        }
+    int umbralPausa() const {
+        int margen = baudios / 500;
+        if (margen < 64) margen = 64;
+        if (margen > CAPACIDAD_COLA_ENTRADA / 2) margen = CAPACIDAD_COLA_ENTRADA / 2;
+        return CAPACIDAD_COLA_ENTRADA - margen;
     }
     
     /**
-     * @brief Imprime el mensaje con formato de fragmentos
+     * @brief Ocupación por debajo de la cual el emisor puede seguir
      */
-    void imprimirConFormato() const {
-        std::cout << "Mensaje: ";
-        NodoCarga* actual = cabeza;
-        while (actual != nullptr) {
-            std::cout << "[" << actual->dato << "]";
-            actual = actual->siguiente;
-        }
-    }
-};
-/**
- * @brief Trama de tipo LOAD - Contiene un carácter para decodificar
- */
-class TramaLoad : public TramaBase {
-private:
-    char caracter;
-    
-public:
-    TramaLoad(char c) : caracter(c) {}
-    
-    void procesar(ListaDeCarga* carga, RotorDeMapeo* rotor) override {
-        char decodificado = rotor->getMapeo(caracter);
-        carga->insertarAlFinal(decodificado);
-        
-        // Manejo especial para el espacio en la impresión
-        char c_print = (caracter == ' ') ? ' ' : caracter;
-        char d_print = (decodificado == ' ') ? ' ' : decodificado;
-        
-        std::cout << "Fragmento '" << c_print << "' decodificado como '" 
-                  << d_print << "'. ";
-        carga->imprimirConFormato();
-        std::cout << std::endl;
+    int umbralReanudar() const {
+        return CAPACIDAD_COLA_ENTRADA / 4;
     }
 };
 
 /**
- * @brief Trama de tipo MAP - Contiene instrucción de rotación
- */
-class TramaMap : public TramaBase {
-private:
-    int rotacion;
-    
-public:
-    TramaMap(int n) : rotacion(n) {}
-    
-    void procesar(ListaDeCarga* carga, RotorDeMapeo* rotor) override {
-        // --- CORRECCIÓN DE COMPILACIÓN ---
-        // Le decimos al compilador que es intencional no usar 'carga'
-        (void)carga; 
-        
-        rotor->rotar(rotacion);
-        
-        std::cout << "ROTANDO ROTOR " << (rotacion >= 0 ? "+" : "") << rotacion 
-                  << ". (Ahora 'A' se mapea a '" << rotor->getCabeza() << "')" 
-                  << std::endl;
-    }
-};
-/**
- * @brief Compara dos cadenas manualmente
+ * @brief Lee el nombre de un control de flujo (ninguno, rtscts o xonxoff)
+ * @return false si el nombre no es válido
  */
-bool sonIguales(const char* str1, const char* str2) {
-    int i = 0;
-    while (str1[i] != '\0' && str2[i] != '\0') {
-        if (str1[i] != str2[i]) return false;
-        i++;
+bool leerControlDeFlujo(const char* nombre, ControlDeFlujo& flujo) {
+    if (sonIguales(nombre, "ninguno")) {
+        flujo = FLUJO_NINGUNO;
+    } else if (sonIguales(nombre, "rtscts")) {
+        flujo = FLUJO_RTSCTS;
+    } else if (sonIguales(nombre, "xonxoff")) {
+        flujo = FLUJO_XONXOFF;
+    } else {
+        return false;
     }
-    return str1[i] == str2[i];
+    return true;
 }
 
 /**
- * @brief Convierte cadena a entero manualmente
+ * @brief Estado del enlace serial visto desde el decodificador (--stats)
  */
-int aEntero(const char* str) {
-    int resultado = 0;
-    int signo = 1;
-    int i = 0;
+struct EstadoDeEnlace {
+    unsigned long long desbordes;   ///< Desbordes reportados por el controlador (bytes perdidos)
+    unsigned long long pausas;      ///< Veces que se frenó al emisor
+    int pendientesMax;              ///< Mayor ocupación de la cola de entrada vista tras una lectura
     
-    if (str[0] == '-') {
-        signo = -1;
-        i = 1;
-    } else if (str[0] == '+') {
-        i = 1;
-    }
+    EstadoDeEnlace() : desbordes(0), pausas(0), pendientesMax(0) {}
     
-    while (str[i] >= '0' && str[i] <= '9') {
-        resultado = resultado * 10 + (str[i] - '0');
-        i++;
+    void acumular(const EstadoDeEnlace& otro) {
+        desbordes += otro.desbordes;
+        pausas += otro.pausas;
+        if (otro.pendientesMax > pendientesMax) pendientesMax = otro.pendientesMax;
     }
-    
-    return resultado * signo;
-}
+};
+
+#ifdef __linux__
+// Definida en puerto_termios2.cpp
+bool configurarBaudiosArbitrarios(int fd, int baudios);
+#endif
 
+#ifdef _WIN32
 /**
- * @brief Parsea una línea del serial y crea la trama correspondiente
+ * @brief Tipo del descriptor de puerto o archivo en Windows
  */
-TramaBase* parsearTrama(char* linea) {
-    // Formato: "L,X" o "M,N"
-    char tipo = linea[0];
-    
-    if (linea[1] != ',') return nullptr; // Trama mal formada
+typedef HANDLE Descriptor;
+const Descriptor DESCRIPTOR_INVALIDO = INVALID_HANDLE_VALUE;
 
-    if (tipo == 'L') {
-        // Trama LOAD
-        char caracter = linea[2];
-        // Manejo especial para 'Space' del README
-        if (linea[2] == 'S' && linea[3] == 'p' && linea[4] == 'a') {
-             caracter = ' ';
-        }
-        return new TramaLoad(caracter);
-    } else if (tipo == 'M') {
-        // Trama MAP
-        int rotacion = aEntero(&linea[2]);
-        return new TramaMap(rotacion);
-    }
-    
-    return nullptr;
-}
-#ifdef _WIN32
 /**
  * @brief Abre puerto serial en Windows
+ * * El DCB acepta cualquier velocidad en BaudRate, no solo las CBR_xxxx.
+ * Con control de flujo, el propio controlador frena al emisor cuando la
+ * cola de entrada pasa de config.umbralPausa() y lo reanuda por debajo de
+ * config.umbralReanudar().
+ * @param config Velocidad, timeout de lectura y control de flujo
+ * @param superpuesto true para abrirlo con FILE_FLAG_OVERLAPPED (E/S asíncrona)
  */
-HANDLE abrirPuertoSerial(const char* puerto) {
+HANDLE abrirPuertoSerial(const char* puerto, const ConfiguracionPuerto& config, bool superpuesto = false) {
     HANDLE hSerial = CreateFileA(
         puerto,
-        GENERIC_READ,
+        config.flujo == FLUJO_XONXOFF ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ,
         0,
         NULL,
         OPEN_EXISTING,
-        FILE_ATTRIBUTE_NORMAL,
+        superpuesto ? FILE_FLAG_OVERLAPPED : FILE_ATTRIBUTE_NORMAL,
         NULL
     );
     
@@ -371,6 +165,8 @@ HANDLE abrirPuertoSerial(const char* puerto) {
         return INVALID_HANDLE_VALUE;
     }
     
+    SetupComm(hSerial, CAPACIDAD_COLA_ENTRADA, CAPACIDAD_COLA_ENTRADA);
+    
     DCB dcbSerialParams = {0};
     dcbSerialParams.DCBlength = sizeof(dcbSerialParams);
     
@@ -379,20 +175,31 @@ HANDLE abrirPuertoSerial(const char* puerto) {
         return INVALID_HANDLE_VALUE;
     }
     
-    dcbSerialParams.BaudRate = CBR_9600;
+    dcbSerialParams.BaudRate = (DWORD)config.baudios;
     dcbSerialParams.ByteSize = 8;
     dcbSerialParams.StopBits = ONESTOPBIT;
     dcbSerialParams.Parity = NOPARITY;
     
+    dcbSerialParams.fOutxCtsFlow = config.flujo == FLUJO_RTSCTS;
+    dcbSerialParams.fRtsControl = config.flujo == FLUJO_RTSCTS ? RTS_CONTROL_HANDSHAKE : RTS_CONTROL_ENABLE;
+    dcbSerialParams.fInX = config.flujo == FLUJO_XONXOFF;
+    dcbSerialParams.fOutX = FALSE;
+    dcbSerialParams.fTXContinueOnXoff = TRUE;
+    // XoffLim cuenta bytes libres y XonLim bytes ocupados de la cola
+    dcbSerialParams.XoffLim = (WORD)(CAPACIDAD_COLA_ENTRADA - config.umbralPausa());
+    dcbSerialParams.XonLim = (WORD)config.umbralReanudar();
+    
     if (!SetCommState(hSerial, &dcbSerialParams)) {
         CloseHandle(hSerial);
         return INVALID_HANDLE_VALUE;
     }
     
+    // MAXDWORD/MAXDWORD/constante: ReadFile regresa en cuanto hay al menos
+    // un byte, o con 0 bytes si no llega nada en config.timeoutMs
     COMMTIMEOUTS timeouts = {0};
-    timeouts.ReadIntervalTimeout = 50;
-    timeouts.ReadTotalTimeoutConstant = 50;
-    timeouts.ReadTotalTimeoutMultiplier = 10;
+    timeouts.ReadIntervalTimeout = MAXDWORD;
+    timeouts.ReadTotalTimeoutMultiplier = MAXDWORD;
+    timeouts.ReadTotalTimeoutConstant = (DWORD)config.timeoutMs;
     
     SetCommTimeouts(hSerial, &timeouts);
     
@@ -400,203 +207,2691 @@ HANDLE abrirPuertoSerial(const char* puerto) {
 }
 
 /**
- * @brief Lee una línea del puerto serial (Windows)
+ * @brief Lee un bloque de bytes disponibles del puerto serial (Windows)
+ * * El timeout ya quedó fijado en COMMTIMEOUTS al abrir el puerto.
+ * @return Bytes leídos, 0 si hubo timeout o -1 si hubo error
  */
-bool leerLineaSerial(HANDLE hSerial, char* buffer, int maxLen) {
-    DWORD bytesLeidos;
-    char c;
-    int pos = 0;
+int leerBloqueSerial(HANDLE hSerial, char* destino, int maxBytes, int /*timeoutMs*/) {
+    DWORD bytesLeidos = 0;
     
-    while (pos < maxLen - 1) {
-        if (!ReadFile(hSerial, &c, 1, &bytesLeidos, NULL)) {
-            return false;
-        }
-        
-        if (bytesLeidos > 0) {
-            if (c == '\n') {
-                buffer[pos] = '\0';
-                return pos > 0; // Solo retorna true si la línea no está vacía
-            } else if (c != '\r') {
-                buffer[pos++] = c;
-            }
-        }
+    if (!ReadFile(hSerial, destino, (DWORD)maxBytes, &bytesLeidos, NULL)) {
+        return -1;
+    }
+    
+    return (int)bytesLeidos;
+}
+
+/**
+ * @brief Consulta la cola de entrada y los errores del puerto (Windows)
+ * * ClearCommError() también borra los errores, así que cada desborde
+ * (CE_OVERRUN de la UART o CE_RXOVER de la cola) se cuenta una sola vez.
+ * @param pendientes Recibe los bytes que esperan en la cola de entrada
+ * @param desbordes Se incrementa si hubo un desborde desde la consulta anterior
+ * @return false si el puerto no admite la consulta
+ */
+bool consultarEnlace(HANDLE hSerial, int& pendientes, unsigned long long& desbordes) {
+    DWORD errores = 0;
+    COMSTAT estado;
+    
+    if (!ClearCommError(hSerial, &errores, &estado)) {
+        return false;
+    }
+    
+    pendientes = (int)estado.cbInQue;
+    if (errores & (CE_OVERRUN | CE_RXOVER)) {
+        desbordes++;
+    }
+    return true;
+}
+
+/**
+ * @brief Abre un archivo de captura para lectura (Windows)
+ * @param ruta Ruta del archivo o "-" para la entrada estándar
+ */
+HANDLE abrirArchivoLectura(const char* ruta) {
+    if (ruta[0] == '-' && ruta[1] == '\0') {
+        return GetStdHandle(STD_INPUT_HANDLE);
+    }
+    
+    return CreateFileA(ruta, GENERIC_READ, FILE_SHARE_READ, NULL,
+                       OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+}
+
+/**
+ * @brief Lee un bloque de un archivo o tubería (Windows)
+ * @return Bytes leídos, 0 al final del archivo o -1 si hubo error
+ */
+int leerBloqueArchivo(HANDLE hArchivo, char* destino, int maxBytes) {
+    DWORD bytesLeidos = 0;
+    
+    if (!ReadFile(hArchivo, destino, (DWORD)maxBytes, &bytesLeidos, NULL)) {
+        // Una tubería cerrada por el escritor equivale a fin de archivo
+        return GetLastError() == ERROR_BROKEN_PIPE ? 0 : -1;
     }
     
-    buffer[pos] = '\0';
-    return pos > 0;
+    return (int)bytesLeidos;
+}
+
+/**
+ * @brief Cierra un puerto o archivo (Windows)
+ */
+void cerrarDescriptor(HANDLE h) {
+    if (h != GetStdHandle(STD_INPUT_HANDLE)) {
+        CloseHandle(h);
+    }
 }
 
 #else
+/**
+ * @brief Tipo del descriptor de puerto o archivo en Linux/Mac
+ */
+typedef int Descriptor;
+const Descriptor DESCRIPTOR_INVALIDO = -1;
+
+/**
+ * @brief Traduce una velocidad en baudios a su constante Bxxxx
+ * @return false si la velocidad no tiene constante estándar
+ */
+bool velocidadEstandar(int baudios, speed_t& velocidad) {
+    static const struct {
+        int baudios;
+        speed_t velocidad;
+    } tabla[] = {
+        {1200, B1200}, {2400, B2400}, {4800, B4800}, {9600, B9600},
+        {19200, B19200}, {38400, B38400}, {57600, B57600},
+        {115200, B115200}, {230400, B230400},
+        #ifdef B460800
+            {460800, B460800},
+        #endif
+        #ifdef B500000
+            {500000, B500000},
+        #endif
+        #ifdef B921600
+            {921600, B921600},
+        #endif
+        #ifdef B1000000
+            {1000000, B1000000},
+        #endif
+        #ifdef B1500000
+            {1500000, B1500000},
+        #endif
+        #ifdef B2000000
+            {2000000, B2000000},
+        #endif
+    };
+    
+    for (size_t i = 0; i < sizeof(tabla) / sizeof(tabla[0]); i++) {
+        if (tabla[i].baudios == baudios) {
+            velocidad = tabla[i].velocidad;
+            return true;
+        }
+    }
+    
+    return false;
+}
+
 /**
  * @brief Abre puerto serial en Linux/Mac
+ * * Las velocidades sin constante Bxxxx se fijan con termios2/BOTHER en
+ * Linux; en otros sistemas se rechazan. Con FLUJO_RTSCTS el controlador
+ * baja RTS cuando se llena la cola de entrada; con FLUJO_XONXOFF el puerto
+ * se abre también para escritura, porque el XOFF se envía por él.
+ * @param config Velocidad, timeout de lectura y control de flujo
  */
-int abrirPuertoSerial(const char* puerto) {
-    int fd = open(puerto, O_RDONLY | O_NOCTTY);
+int abrirPuertoSerial(const char* puerto, const ConfiguracionPuerto& config) {
+    int fd = open(puerto, (config.flujo == FLUJO_XONXOFF ? O_RDWR : O_RDONLY) | O_NOCTTY);
     
     if (fd == -1) {
         return -1;
     }
     
+    speed_t velocidad;
+    bool estandar = velocidadEstandar(config.baudios, velocidad);
+    #ifndef __linux__
+        if (!estandar) {
+            std::cerr << "ERROR: Velocidad no soportada: " << config.baudios << " baudios." << std::endl;
+            close(fd);
+            return -1;
+        }
+    #endif
+    
     struct termios opciones;
     tcgetattr(fd, &opciones);
     
-    cfsetispeed(&opciones, B9600);
+    if (estandar) {
+        cfsetispeed(&opciones, velocidad);
+        cfsetospeed(&opciones, velocidad);
+    }
     opciones.c_cflag |= (CLOCAL | CREAD);
     opciones.c_cflag &= ~PARENB;
     opciones.c_cflag &= ~CSTOPB;
     opciones.c_cflag &= ~CSIZE;
     opciones.c_cflag |= CS8;
+    #ifdef CRTSCTS
+        if (config.flujo == FLUJO_RTSCTS) {
+            opciones.c_cflag |= CRTSCTS;
+        } else {
+            opciones.c_cflag &= ~CRTSCTS;
+        }
+    #else
+        if (config.flujo == FLUJO_RTSCTS) {
+            std::cerr << "ERROR: Control de flujo RTS/CTS no soportado en este sistema." << std::endl;
+            close(fd);
+            return -1;
+        }
+    #endif
+    
+    // Modo no canónico: los bytes se entregan tal como llegan
+    opciones.c_lflag &= ~(ICANON | ECHO | ECHOE | ISIG | IEXTEN);
+    opciones.c_iflag &= ~(IXON | IXOFF | IXANY | ICRNL | INLCR | IGNCR | ISTRIP);
+    if (config.flujo == FLUJO_XONXOFF) {
+        opciones.c_iflag |= IXOFF;  // Último recurso del kernel si la cola se llena
+    }
+    opciones.c_oflag &= ~OPOST;
+    
+    // read() bloquea hasta tener al menos 1 byte; la espera la acota poll()
+    opciones.c_cc[VMIN] = 1;
+    opciones.c_cc[VTIME] = 0;
     
     tcsetattr(fd, TCSANOW, &opciones);
     
+    #ifdef __linux__
+        if (!estandar && !configurarBaudiosArbitrarios(fd, config.baudios)) {
+            std::cerr << "ERROR: Velocidad no soportada: " << config.baudios << " baudios." << std::endl;
+            close(fd);
+            return -1;
+        }
+    #endif
+    
     return fd;
 }
 
 /**
- * @brief Lee una línea del puerto serial (Linux/Mac)
+ * @brief Lee un bloque de bytes disponibles del puerto serial (Linux/Mac)
+ * * Espera con poll() sin consumir CPU y despierta en cuanto llega un byte.
+ * @return Bytes leídos, 0 si hubo timeout o -1 si hubo error o desconexión
  */
-bool leerLineaSerial(int fd, char* buffer, int maxLen) {
-    char c;
-    int pos = 0;
+int leerBloqueSerial(int fd, char* destino, int maxBytes, int timeoutMs) {
+    struct pollfd espera;
+    espera.fd = fd;
+    espera.events = POLLIN;
+    espera.revents = 0;
     
-    while (pos < maxLen - 1) {
-        int n = read(fd, &c, 1);
-        
-        if (n > 0) {
-            if (c == '\n') {
-                buffer[pos] = '\0';
-                return pos > 0; // Solo retorna true si la línea no está vacía
-            } else if (c != '\r') {
-                buffer[pos++] = c;
-            }
-        } else if (n == 0) {
-            // Timeout o fin de datos
-            usleep(10000); // Pequeña pausa
-            if (pos > 0) {
-                buffer[pos] = '\0';
-                return true;
-            }
-            return false;
-        } else {
-            return false;
-        }
-    }
+    int listo = poll(&espera, 1, timeoutMs);
+    
+    if (listo == 0) return 0;   // Timeout: no llegó nada
+    if (listo < 0) return errno == EINTR ? 0 : -1;
+    
+    int n = read(fd, destino, maxBytes);
     
-    buffer[pos] = '\0';
-    return pos > 0;
+    // Listo para leer pero sin bytes: el dispositivo se desconectó
+    return n <= 0 ? -1 : n;
 }
-#endif
+
 /**
- * @brief Función principal del decodificador PRT-7
+ * @brief Consulta la cola de entrada y los desbordes del puerto (Linux/Mac)
+ * * FIONREAD da los bytes que esperan en la cola. En Linux, TIOCGICOUNT da
+ * además los contadores del controlador: overrun (la FIFO de la UART se
+ * llenó) y buf_overrun (no hubo lugar en el buffer del kernel). Los pty y
+ * algunos adaptadores USB no los llevan; en ese caso desbordes no cambia.
+ * @param pendientes Recibe los bytes que esperan en la cola de entrada
+ * @param desbordes Recibe el total de desbordes que lleva el controlador
+ * @return false si el descriptor no admite la consulta
  */
-int main() {
-    std::cout << "========================================" << std::endl;
-    std::cout << "   DECODIFICADOR PRT-7 v1.0" << std::endl;
-    std::cout << "   Sistema de Ciberseguridad Industrial" << std::endl;
-    std::cout << "========================================" << std::endl;
-    std::cout << std::endl;
-    
-    // Inicializar estructuras
-    ListaDeCarga miListaDeCarga;
-    RotorDeMapeo miRotorDeMapeo;
-    
-    std::cout << "Iniciando Decodificador PRT-7. Conectando a puerto COM..." << std::endl;
+bool consultarEnlace(int fd, int& pendientes, unsigned long long& desbordes) {
+    int enCola = 0;
+    if (ioctl(fd, FIONREAD, &enCola) < 0) {
+        return false;
+    }
+    pendientes = enCola;
     
-    // Intentar abrir puerto serial
-    #ifdef _WIN32
-        const char* puertos[] = {"\\\\.\\COM3", "\\\\.\\COM4", "\\\\.\\COM5", "\\\\.\\COM6", "\\\\.\\COM7"};
-        HANDLE hSerial = INVALID_HANDLE_VALUE;
-        
-        for (int i = 0; i < 5; i++) {
-            hSerial = abrirPuertoSerial(puertos[i]);
-            if (hSerial != INVALID_HANDLE_VALUE) {
-                std::cout << "Conexion establecida en " << puertos[i] << std::endl;
-                break;
-            }
-        }
-        
-        if (hSerial == INVALID_HANDLE_VALUE) {
-            std::cerr << "ERROR: No se pudo conectar a ningun puerto COM." << std::endl;
-            std::cerr << "Verifique que el Arduino este conectado." << std::endl;
-            return 1;
+    #if defined(__linux__) && defined(TIOCGICOUNT)
+        struct serial_icounter_struct contadores;
+        if (ioctl(fd, TIOCGICOUNT, &contadores) == 0) {
+            desbordes = (unsigned long long)contadores.overrun + (unsigned long long)contadores.buf_overrun;
         }
     #else
-        const char* puertos[] = {"/dev/ttyUSB0", "/dev/ttyACM0", "/dev/ttyUSB1", "/dev/ttyACM1"};
-        int fd = -1;
-        
-        for (int i = 0; i < 4; i++) {
-            fd = abrirPuertoSerial(puertos[i]);
-            if (fd != -1) {
-                std::cout << "Conexion establecida en " << puertos[i] << std::endl;
-                break;
-            }
-        }
-        std::cerr << "ERROR: No se pudo conectar a ningun puerto serial." << std::endl;
-        
-        if (fd == -1) {
-            std::cerr << "Verifique que el Arduino este conectado." << std::endl;
-            return 1;
-        }
+        (void)desbordes;
     #endif
-    
-    std::cout << "Esperando tramas..." << std::endl << std::endl;
-    
-    // Bucle de procesamiento
-    char buffer[256];
-    int tramasRecibidas = 0;
-    while (true) {
-        #ifdef _WIN32
-            bool hayDatos = leerLineaSerial(hSerial, buffer, 256);
-        #else
-            bool hayDatos = leerLineaSerial(fd, buffer, 256);
-        #endif
-        
-        if (hayDatos) {
-            
-            // 1. Verificar si es la trama de FIN
-            if (sonIguales(buffer, "FIN")) {
-                std::cout << "Trama recibida: [FIN]. Deteniendo." << std::endl;
-                break; // Salir del bucle while(true)
-            }
-            
-            // 2. Verificar si es el saludo inicial (y saltarlo)
-            if (sonIguales(buffer, "SISTEMA PRT-7 ACTIVO")) {
-                std::cout << "Mensaje de control recibido: [SISTEMA PRT-7 ACTIVO]" << std::endl << std::endl;
-                continue; // Saltar al siguiente ciclo de lectura
-            }
+    return true;
+}
 
-            // Si no es FIN ni el saludo, procesar la trama
-            std::cout << "Trama recibida: [" << buffer << "] -> Procesando... -> ";
-            
-            TramaBase* trama = parsearTrama(buffer);
-            
-            if (trama != nullptr) {
-                trama->procesar(&miListaDeCarga, &miRotorDeMapeo);
-                delete trama;
-                tramasRecibidas++;
-            } else {
-                std::cout << "ERROR: Trama mal formada." << std::endl;
-            }
-            
-            std::cout << std::endl;
-        }
+/**
+ * @brief Envía XOFF (pausar) o XON (reanudar) al emisor (Linux/Mac)
+ * @return false si no se pudo enviar
+ */
+bool pausarEmisor(int fd, bool pausar) {
+    return tcflow(fd, pausar ? TCIOFF : TCION) == 0;
+}
+
+/**
+ * @brief Abre un archivo de captura para lectura (Linux/Mac)
+ * @param ruta Ruta del archivo o "-" para la entrada estándar
+ */
+int abrirArchivoLectura(const char* ruta) {
+    if (ruta[0] == '-' && ruta[1] == '\0') {
+        return STDIN_FILENO;
     }
     
-    // Cerrar puerto
-    #ifdef _WIN32
-        CloseHandle(hSerial);
-    #else
+    return open(ruta, O_RDONLY);
+}
+
+/**
+ * @brief Lee un bloque de un archivo o tubería (Linux/Mac)
+ * * Una señal que interrumpe read() no es un error: se reintenta.
+ * @return Bytes leídos, 0 al final del archivo o -1 si hubo error
+ */
+int leerBloqueArchivo(int fd, char* destino, int maxBytes) {
+    int n;
+    do {
+        n = (int)read(fd, destino, maxBytes);
+    } while (n < 0 && errno == EINTR);
+    return n < 0 ? -1 : n;
+}
+
+/**
+ * @brief Cierra un puerto o archivo (Linux/Mac)
+ */
+void cerrarDescriptor(int fd) {
+    if (fd != STDIN_FILENO) {
         close(fd);
-    #endif
+    }
+}
+#endif
+/**
+ * @brief Interfaz para cualquier origen de bytes PRT-7
+ * * Permite que el mismo bucle de decodificación lea del puerto serial, de
+ * un archivo de captura o de la entrada estándar (tuberías).
+ */
+class FuenteDeDatos {
+public:
+    /**
+     * @brief Lee los bytes disponibles
+     * @param destino Buffer donde se copian los bytes
+     * @param maxBytes Capacidad del buffer
+     * @return Bytes leídos, 0 si no hay datos por ahora o -1 si hubo error
+     */
+    virtual int leer(char* destino, int maxBytes) = 0;
+    
+    /**
+     * @brief Indica si la fuente ya no entregará más datos
+     */
+    virtual bool terminada() const = 0;
+    
+    /**
+     * @brief Indica si la fuente terminó por un error de lectura y no por fin de datos
+     */
+    virtual bool fallida() const {
+        return false;
+    }
+    
+    /**
+     * @brief Estado del enlace serial, o nullptr si la fuente no es un puerto
+     */
+    virtual const EstadoDeEnlace* getEnlace() const {
+        return nullptr;
+    }
+    
+    virtual ~FuenteDeDatos() {}
+};
+
+/**
+ * @brief Fuente de datos sobre un puerto serial abierto
+ * * Un 0 de leer() es un timeout; el puerto solo se considera terminado
+ * después de un error (por ejemplo, al desconectar el dispositivo). Después
+ * de cada lectura revisa la cola de entrada del sistema (ver revisarEnlace()).
+ */
+class FuenteSerial : public FuenteDeDatos {
+private:
+    Descriptor descriptor;
+    int timeoutMs;
+    bool fallo;
+    ControlDeFlujo flujo;
+    int umbralPausa;
+    int umbralReanudar;
+    bool pausado;                       // Se envió XOFF y todavía no XON
+    unsigned long long desbordesVistos; // Último total de desbordes del controlador
+    EstadoDeEnlace enlace;
+    
+public:
+    /**
+     * @param config Timeout de lectura y control de flujo con que se abrió el puerto
+     */
+    FuenteSerial(Descriptor d, const ConfiguracionPuerto& config)
+        : descriptor(d), timeoutMs(config.timeoutMs), fallo(false), flujo(config.flujo),
+          umbralPausa(config.umbralPausa()), umbralReanudar(config.umbralReanudar()),
+          pausado(false), desbordesVistos(0) {
+        // Los desbordes anteriores a abrir el puerto no cuentan
+        int pendientes = 0;
+        consultarEnlace(descriptor, pendientes, desbordesVistos);
+    }
+    
+    ~FuenteSerial() override {
+        #ifndef _WIN32
+            if (pausado) pausarEmisor(descriptor, false);
+        #endif
+        cerrarDescriptor(descriptor);
+    }
+    
+    Descriptor getDescriptor() const {
+        return descriptor;
+    }
+    
+    int leer(char* destino, int maxBytes) override {
+        int n = leerBloqueSerial(descriptor, destino, maxBytes, timeoutMs);
+        if (n < 0) {
+            fallo = true;
+            return n;
+        }
+        revisarEnlace();
+        return n;
+    }
+    
+    bool terminada() const override {
+        return fallo;
+    }
+    
+    const EstadoDeEnlace* getEnlace() const override {
+        return &enlace;
+    }
+    
+    /**
+     * @brief Revisa la cola de entrada del sistema después de una lectura
+     * * Avisa en stderr de cada desborde nuevo y registra la ocupación
+     * máxima. Con FLUJO_XONXOFF en Linux/Mac frena al emisor cuando el
+     * decodificador se atrasa (la cola pasa de umbralPausa) y lo reanuda
+     * cuando se pone al día; con FLUJO_RTSCTS, y en Windows con ambos, lo
+     * hace el controlador (ver abrirPuertoSerial()).
+     */
+    void revisarEnlace() {
+        int pendientes = 0;
+        unsigned long long desbordes = desbordesVistos;
+        if (!consultarEnlace(descriptor, pendientes, desbordes)) return;
+        
+        if (pendientes > enlace.pendientesMax) {
+            enlace.pendientesMax = pendientes;
+        }
+        if (desbordes > desbordesVistos) {
+            std::cerr << "AVISO: Desborde en la entrada del puerto (" << desbordes - desbordesVistos
+                      << "); se perdieron bytes." << std::endl;
+            enlace.desbordes += desbordes - desbordesVistos;
+            desbordesVistos = desbordes;
+        }
+        
+        #ifndef _WIN32
+            if (flujo != FLUJO_XONXOFF) return;
+            
+            if (!pausado && pendientes >= umbralPausa) {
+                pausado = pausarEmisor(descriptor, true);
+                if (pausado) enlace.pausas++;
+            } else if (pausado && pendientes <= umbralReanudar) {
+                pausado = !pausarEmisor(descriptor, false);
+            }
+        #endif
+    }
+};
+
+/**
+ * @brief Fuente de datos sobre un archivo de captura o la entrada estándar
+ * * Permite reproducir tráfico grabado (por ejemplo, con
+ * `cat /dev/ttyUSB0 > captura.txt` mientras corre el sketch de arduino.txt)
+ * a máxima velocidad y sin un Arduino conectado. Un error de lectura
+ * también termina la fuente, pero se informa en stderr y queda en fallida()
+ * para que el programa no lo confunda con el fin del archivo.
+ */
+class FuenteArchivo : public FuenteDeDatos {
+private:
+    Descriptor descriptor;
+    bool fin;
+    bool error;
+    
+public:
+    FuenteArchivo(Descriptor d) : descriptor(d), fin(false), error(false) {}
+    
+    ~FuenteArchivo() override {
+        cerrarDescriptor(descriptor);
+    }
+    
+    int leer(char* destino, int maxBytes) override {
+        int n = leerBloqueArchivo(descriptor, destino, maxBytes);
+        if (n < 0 && !error) {
+            std::cerr << "ERROR: Fallo la lectura de la entrada; el mensaje puede estar incompleto." << std::endl;
+            error = true;
+        }
+        if (n <= 0) {
+            fin = true;
+        }
+        return n;
+    }
+    
+    bool terminada() const override {
+        return fin;
+    }
+    
+    bool fallida() const override {
+        return error;
+    }
+};
+
+#ifndef _WIN32
+/**
+ * @brief Sumidero que escribe un mensaje por línea en un descriptor heredado
+ * * Pensado para un socket o una tubería abiertos por quien lanza el proceso
+ * (--sumidero fd:N). Cada mensaje sale en una sola llamada a write()
+ * mientras el núcleo acepte todo; las escrituras parciales se completan.
+ */
+class SumideroDescriptor : public SumideroMensajes {
+private:
+    int descriptor;
+    char* buffer;       // Origen + mensaje + '\n', reutilizado
+    int capacidad;
+    
+public:
+    SumideroDescriptor(int d) : descriptor(d), buffer(nullptr), capacidad(0) {}
+    
+    SumideroDescriptor(const SumideroDescriptor&) = delete;
+    SumideroDescriptor& operator=(const SumideroDescriptor&) = delete;
+    
+    ~SumideroDescriptor() override {
+        delete[] buffer;
+    }
+    
+    bool entregar(const char* mensaje, int longitud, const char* origen) override {
+        int largoOrigen = (int)std::strlen(origen);
+        int total = largoOrigen + longitud + 1;
+        
+        if (total > capacidad) {
+            delete[] buffer;
+            capacidad = total;
+            buffer = new char[capacidad];
+        }
+        std::memcpy(buffer, origen, largoOrigen);
+        std::memcpy(buffer + largoOrigen, mensaje, longitud);
+        buffer[total - 1] = '\n';
+        
+        int escritos = 0;
+        while (escritos < total) {
+            ssize_t n = write(descriptor, buffer + escritos, total - escritos);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            escritos += (int)n;
+        }
+        return true;
+    }
+};
+#endif
+
+/**
+ * @brief Archivo de captura proyectado en memoria (solo lectura)
+ * * Usa mmap en Linux/Mac y CreateFileMapping/MapViewOfFile en Windows. La
+ * región se entrega tal cual a decodificarLote(), que separa las líneas
+ * sobre la propia proyección sin copiarlas.
+ */
+class ArchivoMapeado {
+private:
+    const char* datos;
+    size_t tamanio;
+    #ifdef _WIN32
+        HANDLE hArchivo;
+        HANDLE hMapeo;
+    #endif
+    
+public:
+    #ifdef _WIN32
+        ArchivoMapeado() : datos(nullptr), tamanio(0),
+                           hArchivo(INVALID_HANDLE_VALUE), hMapeo(NULL) {}
+    #else
+        ArchivoMapeado() : datos(nullptr), tamanio(0) {}
+    #endif
+    
+    ArchivoMapeado(const ArchivoMapeado&) = delete;
+    ArchivoMapeado& operator=(const ArchivoMapeado&) = delete;
+    
+    /**
+     * @brief Destructor que libera la proyección
+     */
+    ~ArchivoMapeado() {
+        cerrar();
+    }
+    
+    /**
+     * @brief Proyecta un archivo completo en memoria
+     * @param ruta Ruta del archivo de captura
+     * @return true si se pudo proyectar (un archivo vacío también es válido)
+     */
+    bool abrir(const char* ruta) {
+        cerrar();
+        
+        #ifdef _WIN32
+            hArchivo = CreateFileA(ruta, GENERIC_READ, FILE_SHARE_READ, NULL,
+                                   OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+            if (hArchivo == INVALID_HANDLE_VALUE) return false;
+            
+            LARGE_INTEGER tam;
+            if (!GetFileSizeEx(hArchivo, &tam)) {
+                cerrar();
+                return false;
+            }
+            tamanio = (size_t)tam.QuadPart;
+            if (tamanio == 0) return true;
+            
+            hMapeo = CreateFileMappingA(hArchivo, NULL, PAGE_READONLY, 0, 0, NULL);
+            if (hMapeo == NULL) {
+                cerrar();
+                return false;
+            }
+            
+            datos = static_cast<const char*>(MapViewOfFile(hMapeo, FILE_MAP_READ, 0, 0, 0));
+            if (datos == nullptr) {
+                cerrar();
+                return false;
+            }
+        #else
+            int fd = open(ruta, O_RDONLY);
+            if (fd == -1) return false;
+            
+            struct stat info;
+            if (fstat(fd, &info) != 0) {
+                close(fd);
+                return false;
+            }
+            tamanio = (size_t)info.st_size;
+            if (tamanio == 0) {
+                close(fd);
+                return true;
+            }
+            
+            void* region = mmap(nullptr, tamanio, PROT_READ, MAP_PRIVATE, fd, 0);
+            close(fd); // La proyección sigue siendo válida sin el descriptor
+            
+            if (region == MAP_FAILED) {
+                tamanio = 0;
+                return false;
+            }
+            
+            madvise(region, tamanio, MADV_SEQUENTIAL);
+            datos = static_cast<const char*>(region);
+        #endif
+        
+        return true;
+    }
+    
+    /**
+     * @brief Libera la proyección y el archivo
+     */
+    void cerrar() {
+        #ifdef _WIN32
+            if (datos != nullptr) UnmapViewOfFile(datos);
+            if (hMapeo != NULL) CloseHandle(hMapeo);
+            if (hArchivo != INVALID_HANDLE_VALUE) CloseHandle(hArchivo);
+            hMapeo = NULL;
+            hArchivo = INVALID_HANDLE_VALUE;
+        #else
+            if (datos != nullptr) munmap(const_cast<char*>(datos), tamanio);
+        #endif
+        datos = nullptr;
+        tamanio = 0;
+    }
+    
+    const char* getDatos() const {
+        return datos;
+    }
+    
+    size_t getTamanio() const {
+        return tamanio;
+    }
+};
+
+/**
+ * @brief Abre el puerto indicado o el primero disponible de la lista conocida
+ * @param preferido Puerto a usar, o nullptr para probar la lista conocida
+ * @param config Velocidad y timeout con los que se abre el puerto
+ * @return Fuente sobre el puerto (liberar con delete) o nullptr
+ */
+FuenteSerial* conectarPuertoSerial(const char* preferido, const ConfiguracionPuerto& config) {
+    #ifdef _WIN32
+        const char* conocidos[] = {"\\\\.\\COM3", "\\\\.\\COM4", "\\\\.\\COM5", "\\\\.\\COM6", "\\\\.\\COM7"};
+    #else
+        const char* conocidos[] = {"/dev/ttyUSB0", "/dev/ttyACM0", "/dev/ttyUSB1", "/dev/ttyACM1"};
+    #endif
+    const char** puertos = conocidos;
+    int cantidad = sizeof(conocidos) / sizeof(conocidos[0]);
+    
+    if (preferido != nullptr) {
+        puertos = &preferido;
+        cantidad = 1;
+    }
+    
+    for (int i = 0; i < cantidad; i++) {
+        Descriptor d = abrirPuertoSerial(puertos[i], config);
+        if (d != DESCRIPTOR_INVALIDO) {
+            std::cout << "Conexion establecida en " << puertos[i]
+                      << " a " << config.baudios << " baudios"
+                      << (config.flujo == FLUJO_RTSCTS ? " (flujo RTS/CTS)"
+                          : config.flujo == FLUJO_XONXOFF ? " (flujo XON/XOFF)" : "") << '\n';
+            return new FuenteSerial(d, config);
+        }
+    }
+    
+    return nullptr;
+}
+/**
+ * @brief Carga los parámetros del puerto desde un archivo de configuración
+ * * Una clave por línea con el formato `clave = valor`; las líneas vacías y
+ * las que empiezan con '#' se ignoran. Claves: `puerto`, `baudios`,
+ * `timeout` (en milisegundos) y `flujo` (ninguno, rtscts o xonxoff).
+ * @return false si el archivo no existe o tiene una línea inválida
+ */
+bool cargarConfiguracion(const char* ruta, ConfiguracionPuerto& config) {
+    FILE* archivo = std::fopen(ruta, "r");
+    if (archivo == nullptr) {
+        std::cerr << "ERROR: No se pudo abrir " << ruta << "." << std::endl;
+        return false;
+    }
+    
+    char linea[ConfiguracionPuerto::MAX_RUTA + 32];
+    int numero = 0;
+    bool valida = true;
+    
+    while (valida && std::fgets(linea, sizeof(linea), archivo) != nullptr) {
+        numero++;
+        
+        // Recortar espacios y fin de línea en ambos extremos
+        char* clave = linea;
+        while (*clave == ' ' || *clave == '\t') clave++;
+        int longitud = (int)std::strlen(clave);
+        while (longitud > 0 && (clave[longitud - 1] == '\n' || clave[longitud - 1] == '\r' ||
+                                clave[longitud - 1] == ' ' || clave[longitud - 1] == '\t')) {
+            clave[--longitud] = '\0';
+        }
+        
+        if (longitud == 0 || clave[0] == '#') continue;
+        
+        char* igual = std::strchr(clave, '=');
+        if (igual == nullptr) {
+            valida = false;
+            break;
+        }
+        
+        char* valor = igual + 1;
+        while (*valor == ' ' || *valor == '\t') valor++;
+        
+        int longitudClave = (int)(igual - clave);
+        while (longitudClave > 0 && (clave[longitudClave - 1] == ' ' || clave[longitudClave - 1] == '\t')) {
+            longitudClave--;
+        }
+        clave[longitudClave] = '\0';
+        
+        int longitudValor = (int)std::strlen(valor);
+        
+        if (sonIguales(clave, "puerto")) {
+            valida = longitudValor > 0 && longitudValor < ConfiguracionPuerto::MAX_RUTA;
+            if (valida) std::memcpy(config.dispositivo, valor, longitudValor + 1);
+        } else if (sonIguales(clave, "baudios")) {
+            config.baudios = aEntero(valor, longitudValor);
+            valida = config.baudios > 0;
+        } else if (sonIguales(clave, "timeout")) {
+            config.timeoutMs = aEntero(valor, longitudValor);
+            valida = config.timeoutMs > 0;
+        } else if (sonIguales(clave, "flujo")) {
+            valida = leerControlDeFlujo(valor, config.flujo);
+        } else {
+            valida = false;
+        }
+    }
+    
+    std::fclose(archivo);
+    
+    if (!valida) {
+        std::cerr << "ERROR: Linea " << numero << " invalida en " << ruta << "." << std::endl;
+    }
+    return valida;
+}
+
+/**
+ * @brief Vista de una línea completa dentro del buffer del lector
+ * * Apunta directamente a la memoria del lector y termina en '\0', por lo
+ * que es válida únicamente hasta la siguiente llamada a leerLinea(). En
+ * modo binario apunta a una trama binaria y no termina en '\0'.
+ */
+struct VistaLinea {
+    char* datos;
+    int longitud;
+    bool truncada;  ///< La línea no cupo en el buffer: datos es solo su comienzo
+    
+    VistaLinea() : datos(nullptr), longitud(0), truncada(false) {}
+};
+
+/**
+ * @brief Lector de líneas con buffer sobre cualquier FuenteDeDatos
+ * * En lugar de una llamada al sistema por byte, lee bloques completos en
+ * un buffer interno y entrega las líneas terminadas en '\n' como vistas
+ * sobre ese mismo buffer. Los bytes sin consumir se compactan al inicio
+ * cuando el buffer llega a su final. En modo binario entrega, sobre el
+ * mismo buffer, tramas delimitadas por medirTramaBinaria() en lugar de
+ * líneas. Una línea que no cabe en el buffer se entrega una sola vez,
+ * marcada como truncada, y el resto se descarta hasta el siguiente '\n'.
+ */
+class LectorDeLineas {
+private:
+    static const int CAPACIDAD = 4096;
+    
+    FuenteDeDatos& fuente;
+    char buffer[CAPACIDAD + 1]; // +1 para el '\0' de una línea que llena el buffer
+    int inicio;     // Primer byte sin consumir
+    int fin;        // Fin de los datos válidos
+    int revisado;   // Hasta dónde ya se buscó el '\n'
+    bool binario;   // Tramas binarias en lugar de líneas
+    bool descartando;   // Se entregó una línea truncada y falta su '\n'
+    bool medicion;  // Marcar la hora de cada lectura (--stats)
+    unsigned long long marcaLectura;   // relojNs() de la última lectura
+    unsigned long long bytesLeidos;    // Total recibido de la fuente
+    
+    /**
+     * @brief Entrega los bytes [inicio, finLinea) como línea terminada en '\0'
+     */
+    void entregar(int finLinea, VistaLinea& linea) {
+        int longitud = finLinea - inicio;
+        
+        // Descartar el '\r' del final de línea
+        if (longitud > 0 && buffer[inicio + longitud - 1] == '\r') {
+            longitud--;
+        }
+        
+        buffer[inicio + longitud] = '\0';
+        linea.datos = &buffer[inicio];
+        linea.longitud = longitud;
+        linea.truncada = false;
+    }
+    
+    /**
+     * @brief Mueve los bytes pendientes al inicio del buffer
+     */
+    void compactar() {
+        int pendientes = fin - inicio;
+        std::memmove(buffer, &buffer[inicio], pendientes);
+        revisado -= inicio;
+        inicio = 0;
+        fin = pendientes;
+    }
+    
+    /**
+     * @brief Entrega la siguiente trama binaria completa ya presente en el buffer
+     * * Un código inválido se entrega como trama de 1 byte para que el
+     * llamador lo reporte; así el lector se resincroniza byte a byte.
+     */
+    bool extraerTramaBinaria(VistaLinea& trama) {
+        int longitud = medirTramaBinaria(&buffer[inicio], fin - inicio);
+        
+        if (longitud == 0) {
+            // Trama incompleta: dejar lugar para el resto
+            if (fin == CAPACIDAD && inicio > 0) {
+                compactar();
+            }
+            return false;
+        }
+        
+        if (longitud < 0) longitud = 1;
+        
+        trama.datos = &buffer[inicio];
+        trama.longitud = longitud;
+        trama.truncada = false;
+        inicio = revisado = inicio + longitud;
+        return true;
+    }
+    
+public:
+    /**
+     * @brief Constructor que asocia el lector a una fuente ya abierta
+     * @param f Fuente de la que se leen los bloques
+     */
+    LectorDeLineas(FuenteDeDatos& f)
+        : fuente(f), inicio(0), fin(0), revisado(0), binario(false), descartando(false),
+          medicion(false), marcaLectura(0), bytesLeidos(0) {}
+    
+    /**
+     * @brief Cambia entre líneas de texto y tramas binarias
+     * * Los bytes ya recibidos después de la línea actual se interpretan
+     * con el nuevo modo.
+     */
+    void setBinario(bool b) {
+        binario = b;
+        descartando = false;
+    }
+    
+    bool esBinario() const {
+        return binario;
+    }
+    
+    /**
+     * @brief Activa la marca de tiempo de cada bloque leído
+     * * Apagada no cuesta nada; encendida, una lectura del reloj por bloque.
+     */
+    void setMedicion(bool m) {
+        medicion = m;
+    }
+    
+    /**
+     * @brief Hora (relojNs()) en que llegó el bloque que completó la última
+     *        línea entregada; 0 si la medición está apagada
+     */
+    unsigned long long getMarcaLectura() const {
+        return marcaLectura;
+    }
+    
+    unsigned long long getBytesLeidos() const {
+        return bytesLeidos;
+    }
+    
+    /**
+     * @brief Entrega una línea completa ya presente en el buffer, sin leer
+     * @param linea Vista que recibe la línea (sin '\r' ni '\n')
+     * @return true si había una línea completa (o el buffer se llenó)
+     */
+    bool extraerLinea(VistaLinea& linea) {
+        if (binario) return extraerTramaBinaria(linea);
+        
+        // 1. Buscar un '\n' en los datos que aún no se revisaron
+        while (revisado < fin) {
+            if (buffer[revisado] == '\n') {
+                int finLinea = revisado;
+                
+                if (descartando) {
+                    // Resto de una línea que ya se entregó truncada
+                    descartando = false;
+                    inicio = revisado = finLinea + 1;
+                    continue;
+                }
+                
+                entregar(finLinea, linea);
+                inicio = revisado = finLinea + 1;
+                
+                if (linea.longitud > 0) return true;
+                continue; // Línea vacía: seguir buscando
+            }
+            revisado++;
+        }
+        
+        // 2. Si ya no cabe nada al final, mover lo pendiente al inicio
+        if (fin == CAPACIDAD && inicio > 0) {
+            compactar();
+        }
+        
+        // 3. Línea más larga que el buffer: entregarla marcada como truncada
+        //    la primera vez y descartar lo que siga hasta su '\n'
+        if (fin - inicio == CAPACIDAD) {
+            bool informada = descartando;
+            entregar(fin, linea);
+            linea.truncada = true;
+            inicio = fin = revisado = 0;
+            descartando = true;
+            if (!informada) return true;
+        }
+        
+        return false;
+    }
+    
+    /**
+     * @brief Hace una sola lectura de la fuente hacia el buffer
+     * * Debe llamarse después de que extraerLinea() devolvió false, lo que
+     * garantiza espacio libre al final del buffer.
+     * @return Lo que devolvió FuenteDeDatos::leer()
+     */
+    int rellenar() {
+        int n = fuente.leer(&buffer[fin], CAPACIDAD - fin);
+        if (n > 0) {
+            fin += n;
+            bytesLeidos += n;
+            if (medicion) marcaLectura = relojNs();
+        }
+        return n;
+    }
+    
+    /**
+     * @brief Copia al buffer bytes que ya se leyeron por otra vía
+     * * Para lecturas asíncronas que completan en un buffer propio.
+     * @return Bytes aceptados (puede ser menos que cantidad si no caben)
+     */
+    int agregar(const char* datos, int cantidad) {
+        if (CAPACIDAD - fin < cantidad && inicio > 0) {
+            compactar();
+        }
+        
+        int libres = CAPACIDAD - fin;
+        int copiados = cantidad < libres ? cantidad : libres;
+        std::memcpy(&buffer[fin], datos, copiados);
+        fin += copiados;
+        bytesLeidos += copiados;
+        if (medicion) marcaLectura = relojNs();
+        return copiados;
+    }
+    
+    /**
+     * @brief Obtiene la siguiente línea no vacía de la fuente
+     * @param linea Vista que recibe la línea (sin '\r' ni '\n')
+     * @return true si se obtuvo una línea, false si hubo timeout, fin de
+     *         datos o error
+     */
+    bool leerLinea(VistaLinea& linea) {
+        while (true) {
+            if (extraerLinea(linea)) return true;
+            
+            // 4. Traer un nuevo bloque de la fuente
+            int n = rellenar();
+            
+            if (n > 0) {
+                continue;
+            } else if (n == 0 && fin > inicio && !binario) {
+                // Timeout o fin de datos con una línea parcial: entregarla,
+                // salvo que sea el resto de una línea truncada
+                entregar(fin, linea);
+                inicio = fin = revisado = 0;
+                if (descartando) {
+                    descartando = false;
+                    return false;
+                }
+                return linea.longitud > 0;
+            } else {
+                return false;
+            }
+        }
+    }
+};
+/**
+ * @brief Cola lock-free de un productor y un consumidor
+ * * El productor solo escribe 'cola' y el consumidor solo escribe 'cabeza';
+ * cada uno lee el índice del otro con semántica acquire/release, por lo que
+ * no hacen falta mutex. CAPACIDAD debe ser potencia de 2.
+ */
+template <typename T, size_t CAPACIDAD>
+class ColaSPSC {
+private:
+    static_assert((CAPACIDAD & (CAPACIDAD - 1)) == 0, "CAPACIDAD debe ser potencia de 2");
+    
+    T elementos[CAPACIDAD];
+    alignas(64) std::atomic<size_t> cabeza;    // Próximo elemento a consumir
+    alignas(64) std::atomic<size_t> cola;      // Próxima posición a producir
+    
+public:
+    ColaSPSC() : cabeza(0), cola(0) {}
+    
+    /**
+     * @brief Espacio para el próximo elemento, o nullptr si la cola está llena
+     * * El productor llena el elemento y luego llama a publicar().
+     */
+    T* reservar() {
+        size_t c = cola.load(std::memory_order_relaxed);
+        if (c - cabeza.load(std::memory_order_acquire) == CAPACIDAD) return nullptr;
+        return &elementos[c & (CAPACIDAD - 1)];
+    }
+    
+    /**
+     * @brief Hace visible al consumidor el elemento reservado
+     */
+    void publicar() {
+        cola.store(cola.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+    
+    /**
+     * @brief Próximo elemento a consumir, o nullptr si la cola está vacía
+     * * El consumidor lo usa y luego llama a liberar().
+     */
+    T* frente() {
+        size_t h = cabeza.load(std::memory_order_relaxed);
+        if (h == cola.load(std::memory_order_acquire)) return nullptr;
+        return &elementos[h & (CAPACIDAD - 1)];
+    }
+    
+    /**
+     * @brief Devuelve al productor el elemento consumido
+     */
+    void liberar() {
+        cabeza.store(cabeza.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+};
+
+/**
+ * @brief Espera activa con retroceso: primero cede el hilo y luego duerme
+ */
+inline void esperarConRetroceso(int& intentos) {
+    if (++intentos < 64) {
+        std::this_thread::yield();
+    } else {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+}
+
+/**
+ * @brief Línea copiada del buffer del lector para cruzar entre hilos
+ * * Ninguna trama PRT-7 válida se acerca a MAX_LINEA; una línea más larga
+ * viaja marcada como truncada y se rechaza.
+ */
+struct LineaCruda {
+    static const int MAX_LINEA = 256;
+    
+    char datos[MAX_LINEA];
+    int longitud;   ///< -1 marca el fin de la entrada
+    bool binaria;   ///< datos es una trama binaria, no una línea de texto
+    bool truncada;  ///< La línea no cupo en datos ni en el lector (ver VistaLinea)
+    unsigned long long recibidaNs;   ///< Marca de lectura (ver LectorDeLineas)
+    unsigned long long bytesLeidos;  ///< Bytes leídos por el hilo de E/S hasta aquí
+};
+
+/**
+ * @brief Resultado de procesar una línea recibida
+ */
+enum ResultadoLinea {
+    LINEA_TRAMA,        ///< Trama LOAD o MAP aplicada
+    LINEA_CONTROL,      ///< Mensaje de control (saludo)
+    LINEA_INVALIDA,     ///< Trama mal formada
+    LINEA_FIN,          ///< Trama FIN: detener la decodificación
+    LINEA_BINARIO       ///< Control "MODO BINARIO": lo que sigue son tramas binarias
+};
+
+/**
+ * @brief Imprime una duración en ns con la unidad más legible
+ */
+void imprimirDuracion(std::ostream& salida, unsigned long long ns) {
+    char texto[32];
+    if (ns < 1000ULL) {
+        std::snprintf(texto, sizeof(texto), "%lluns", ns);
+    } else if (ns < 1000000ULL) {
+        std::snprintf(texto, sizeof(texto), "%.1fus", ns / 1e3);
+    } else if (ns < 1000000000ULL) {
+        std::snprintf(texto, sizeof(texto), "%.1fms", ns / 1e6);
+    } else {
+        std::snprintf(texto, sizeof(texto), "%.2fs", ns / 1e9);
+    }
+    salida << texto;
+}
+
+/**
+ * @brief Contadores e histogramas del camino de decodificación (--stats)
+ * * Las funciones de procesamiento reciben un puntero a esta estructura que
+ * es nullptr cuando la instrumentación está apagada; en ese caso el costo
+ * es una comparación por trama. Todo se imprime en std::cerr para no
+ * mezclarse con el mensaje en la salida estándar.
+ */
+struct MetricasDecodificador {
+    unsigned long long tramas;          ///< Tramas LOAD/MAP aplicadas
+    unsigned long long malformadas;     ///< Tramas rechazadas por el análisis
+    unsigned long long truncadas;       ///< De ellas, líneas que no cupieron en el buffer
+    unsigned long long control;         ///< Líneas de control (saludo, modo)
+    unsigned long long bytesLeidos;     ///< Bytes recibidos de la fuente
+    EstadoDeEnlace enlace;              ///< Puertos seriales, acumulado al cerrarlos
+    bool hayEnlace;                     ///< Se leyó de al menos un puerto serial
+    HistogramaLatencia latencia;        ///< Bytes leídos -> trama decodificada
+    HistogramaLatencia analisis;        ///< analizarTrama()/analizarTramaBinaria()
+    HistogramaLatencia rotor;           ///< rotar()/getMapeo()
+    unsigned long long inicioNs;
+    unsigned long long intervaloNs;     ///< Cada cuánto imprimir una línea (0 = nunca)
+    unsigned long long proximoReporteNs;
+    
+    MetricasDecodificador()
+        : tramas(0), malformadas(0), truncadas(0), control(0), bytesLeidos(0), hayEnlace(false),
+          inicioNs(relojNs()), intervaloNs(0), proximoReporteNs(0) {}
+    
+    /**
+     * @brief Activa la línea periódica de estadísticas
+     * @param segundos Intervalo entre líneas
+     */
+    void setIntervalo(int segundos) {
+        intervaloNs = (unsigned long long)segundos * 1000000000ULL;
+        proximoReporteNs = inicioNs + intervaloNs;
+    }
+    
+    /**
+     * @brief Suma el estado de un puerto serial al terminar de leerlo
+     * @param e Estado de la fuente, o nullptr si no era un puerto
+     */
+    void registrarEnlace(const EstadoDeEnlace* e) {
+        if (e == nullptr) return;
+        enlace.acumular(*e);
+        hayEnlace = true;
+    }
+    
+    /**
+     * @brief Cuenta el resultado de una entrada y su latencia desde la lectura
+     * @param recibidaNs Marca del lector al entregar la entrada (0 = sin marca)
+     */
+    void registrar(ResultadoLinea resultado, unsigned long long recibidaNs) {
+        unsigned long long ahora = relojNs();
+        
+        if (resultado == LINEA_TRAMA) {
+            tramas++;
+            if (recibidaNs != 0) latencia.registrar(ahora - recibidaNs);
+        } else if (resultado == LINEA_INVALIDA) {
+            malformadas++;
+        } else if (resultado == LINEA_CONTROL || resultado == LINEA_BINARIO) {
+            control++;
+        }
+        
+        if (intervaloNs != 0 && ahora >= proximoReporteNs) {
+            reportar(ahora);
+        }
+    }
+    
+    /**
+     * @brief Imprime la línea periódica si ya pasó el intervalo
+     * * Para los bucles que despiertan por timeout sin recibir tramas.
+     */
+    void revisarIntervalo() {
+        if (intervaloNs == 0) return;
+        
+        unsigned long long ahora = relojNs();
+        if (ahora >= proximoReporteNs) {
+            reportar(ahora);
+        }
+    }
+    
+    /**
+     * @brief Imprime una línea con el estado acumulado
+     */
+    void reportar(unsigned long long ahora) {
+        double segundos = (ahora - inicioNs) / 1e9;
+        char texto[160];
+        std::snprintf(texto, sizeof(texto),
+                      "[stats] t=%.1fs tramas=%llu (%.1f/s) malformadas=%llu bytes=%llu",
+                      segundos, tramas, segundos > 0 ? tramas / segundos : 0.0,
+                      malformadas, bytesLeidos);
+        std::cerr << texto << " latencia p50=";
+        imprimirDuracion(std::cerr, latencia.percentil(50));
+        std::cerr << " p99=";
+        imprimirDuracion(std::cerr, latencia.percentil(99));
+        std::cerr << std::endl;
+        
+        proximoReporteNs = ahora + intervaloNs;
+    }
+    
+    /**
+     * @brief Imprime el resumen completo (--stats al terminar)
+     */
+    void imprimirResumen() const {
+        double segundos = (relojNs() - inicioNs) / 1e9;
+        char texto[160];
+        
+        std::cerr << "=== Estadisticas ===" << std::endl;
+        std::snprintf(texto, sizeof(texto), "Tiempo: %.3f s", segundos);
+        std::cerr << texto << std::endl;
+        std::snprintf(texto, sizeof(texto),
+                      "Tramas: %llu (%.1f tramas/s) | Mal formadas: %llu | Control: %llu",
+                      tramas, segundos > 0 ? tramas / segundos : 0.0, malformadas, control);
+        std::cerr << texto << std::endl;
+        std::snprintf(texto, sizeof(texto), "Bytes leidos: %llu (%.1f B/s)",
+                      bytesLeidos, segundos > 0 ? bytesLeidos / segundos : 0.0);
+        std::cerr << texto << std::endl;
+        if (truncadas > 0) {
+            std::snprintf(texto, sizeof(texto), "Lineas truncadas (contadas como mal formadas): %llu", truncadas);
+            std::cerr << texto << std::endl;
+        }
+        if (hayEnlace) {
+            std::snprintf(texto, sizeof(texto),
+                          "Enlace serial: desbordes %llu | cola de entrada max %d/%d bytes | pausas %llu",
+                          enlace.desbordes, enlace.pendientesMax, CAPACIDAD_COLA_ENTRADA, enlace.pausas);
+            std::cerr << texto << std::endl;
+        }
+        
+        imprimirHistograma("Latencia lectura->decodificada", latencia);
+        imprimirHistograma("Analisis de trama", analisis);
+        imprimirHistograma("Rotor (rotar/getMapeo)", rotor);
+    }
+    
+    static void imprimirHistograma(const char* nombre, const HistogramaLatencia& h) {
+        if (h.getCuenta() == 0) return;
+        
+        std::cerr << nombre << ": n=" << h.getCuenta() << " min=";
+        imprimirDuracion(std::cerr, h.getMinimo());
+        std::cerr << " prom=";
+        imprimirDuracion(std::cerr, h.getPromedio());
+        std::cerr << " p50=";
+        imprimirDuracion(std::cerr, h.percentil(50));
+        std::cerr << " p90=";
+        imprimirDuracion(std::cerr, h.percentil(90));
+        std::cerr << " p99=";
+        imprimirDuracion(std::cerr, h.percentil(99));
+        std::cerr << " p99.9=";
+        imprimirDuracion(std::cerr, h.percentil(99.9));
+        std::cerr << " max=";
+        imprimirDuracion(std::cerr, h.getMaximo());
+        std::cerr << std::endl;
+    }
+};
+
+/**
+ * @brief procesarTrama() midiendo solo la operación del rotor
+ */
+void procesarTramaMedida(const Trama& trama, ListaDeCarga& carga, RotorDeMapeo& rotor,
+                         HistogramaLatencia& tiempoRotor) {
+    if (trama.tipo == TRAMA_LOAD) {
+        unsigned long long t0 = relojNs();
+        char decodificado = rotor.getMapeo(trama.caracter);
+        tiempoRotor.registrar(relojNs() - t0);
+        
+        carga.insertarAlFinal(decodificado);
+        TramaLoad::informar(trama.caracter, decodificado, &carga);
+    } else if (trama.tipo == TRAMA_MAP) {
+        unsigned long long t0 = relojNs();
+        rotarRotor(rotor, trama.destino, trama.rotacion);
+        tiempoRotor.registrar(relojNs() - t0);
+        
+        TramaMap::informar(trama.rotacion, &carga, &rotor, trama.destino);
+    }
+}
+
+/**
+ * @brief Aplica una trama ya analizada e imprime su avance según el modo
+ * @param texto Representación de la trama para la salida
+ * @param valida Resultado del análisis
+ * @param inicio Prefijo de cada salida ("" si no hay)
+ */
+ResultadoLinea aplicarTramaAnalizada(const char* texto, bool valida, const Trama& trama,
+                                     ListaDeCarga& carga, RotorDeMapeo& rotor,
+                                     const char* inicio, MetricasDecodificador* metricas) {
+    bool detallado = (carga.getModoImpresion() != IMPRESION_SILENCIOSA);
+    if (detallado) {
+        std::cout << inicio << "Trama recibida: [" << texto << "] -> Procesando... -> ";
+    }
+    
+    ResultadoLinea resultado = LINEA_TRAMA;
+    if (valida && metricas != nullptr) {
+        procesarTramaMedida(trama, carga, rotor, metricas->rotor);
+    } else if (valida) {
+        procesarTrama(trama, &carga, &rotor);
+    } else {
+        resultado = LINEA_INVALIDA;
+        if (detallado) {
+            std::cout << "ERROR: Trama mal formada.\n";
+        }
+    }
+    
+    if (detallado) {
+        std::cout << '\n';
+    }
+    
+    return resultado;
+}
+
+/**
+ * @brief Procesa una línea completa e imprime su avance según el modo
+ * @param linea Línea terminada en '\0' (sin '\r' ni '\n')
+ * @param longitud Bytes de la línea
+ * @param prefijo Texto al inicio de cada salida (p. ej. el puerto), o nullptr
+ * @param metricas Instrumentación, o nullptr si está apagada
+ */
+ResultadoLinea procesarLinea(const char* linea, int longitud,
+                             ListaDeCarga& carga, RotorDeMapeo& rotor,
+                             const char* prefijo = nullptr,
+                             MetricasDecodificador* metricas = nullptr) {
+    Trama trama;
+    const char* inicio = prefijo ? prefijo : "";
+    
+    // Una sola pasada clasifica tanto las líneas de control como las tramas
+    unsigned long long t0 = metricas ? relojNs() : 0;
+    TipoTrama tipo = clasificarLinea(linea, longitud, trama);
+    if (metricas) metricas->analisis.registrar(relojNs() - t0);
+    
+    switch (tipo) {
+        case TRAMA_FIN:
+            std::cout << inicio << "Trama recibida: [FIN]. Deteniendo.\n";
+            return LINEA_FIN;
+            
+        case TRAMA_SALUDO:
+            // El saludo inicial se informa y se salta
+            std::cout << inicio << "Mensaje de control recibido: [" << TEXTO_SALUDO << "]\n\n";
+            return LINEA_CONTROL;
+            
+        case TRAMA_MODO_BINARIO:
+            // El emisor pasa al formato binario (ver CodigoBinario)
+            std::cout << inicio << "Mensaje de control recibido: [" << TEXTO_MODO_BINARIO << "]\n\n";
+            return LINEA_BINARIO;
+            
+        default:
+            return aplicarTramaAnalizada(linea, tipo != TRAMA_INVALIDA, trama, carga, rotor,
+                                         inicio, metricas);
+    }
+}
+
+/**
+ * @brief Procesa una trama binaria entregada por LectorDeLineas
+ * * Imprime lo mismo que la trama de texto equivalente ("L,X", "M,N").
+ * @param datos Trama delimitada por medirTramaBinaria() (sin '\0')
+ * @param longitud Bytes de la trama
+ * @param prefijo Texto al inicio de cada salida (p. ej. el puerto), o nullptr
+ * @param metricas Instrumentación, o nullptr si está apagada
+ */
+ResultadoLinea procesarTramaBinaria(const char* datos, int longitud,
+                                    ListaDeCarga& carga, RotorDeMapeo& rotor,
+                                    const char* prefijo = nullptr,
+                                    MetricasDecodificador* metricas = nullptr) {
+    Trama trama;
+    const char* inicio = prefijo ? prefijo : "";
+    
+    unsigned long long t0 = metricas ? relojNs() : 0;
+    bool valida = analizarTramaBinaria(datos, longitud, trama);
+    if (metricas) metricas->analisis.registrar(relojNs() - t0);
+    
+    if (trama.tipo == TRAMA_FIN) {
+        std::cout << inicio << "Trama recibida: [FIN]. Deteniendo.\n";
+        return LINEA_FIN;
+    }
+    
+    // Solo hace falta el texto si se va a imprimir
+    char texto[MAX_TRAMA_BINARIA * 5 + 1] = "";
+    if (carga.getModoImpresion() != IMPRESION_SILENCIOSA) {
+        if (trama.tipo == TRAMA_LOAD) {
+            std::snprintf(texto, sizeof(texto), "L,%c", trama.caracter);
+        } else if (trama.tipo == TRAMA_MAP) {
+            std::snprintf(texto, sizeof(texto), "M,%d", trama.rotacion);
+        } else {
+            // Bytes en hexadecimal separados por espacios
+            int escritos = 0;
+            for (int i = 0; i < longitud && i < MAX_TRAMA_BINARIA; i++) {
+                escritos += std::snprintf(&texto[escritos], sizeof(texto) - escritos,
+                                          i == 0 ? "0x%02X" : " 0x%02X", (unsigned char)datos[i]);
+            }
+        }
+    }
+    
+    return aplicarTramaAnalizada(texto, valida, trama, carga, rotor, inicio, metricas);
+}
+
+/**
+ * @brief Rechaza una línea que no cupo en el buffer
+ * * Recortada podría analizarse como otra trama válida (por ejemplo, un MAP
+ * con la rotación cortada), así que cuenta como mal formada sin analizarse.
+ * @param linea Comienzo de la línea
+ * @param longitud Bytes que alcanzaron a entrar
+ */
+ResultadoLinea procesarLineaTruncada(const char* linea, int longitud, const ListaDeCarga& carga,
+                                     const char* prefijo = nullptr,
+                                     MetricasDecodificador* metricas = nullptr) {
+    if (metricas) metricas->truncadas++;
+    
+    if (carga.getModoImpresion() != IMPRESION_SILENCIOSA) {
+        std::cout << (prefijo ? prefijo : "") << "Trama recibida: [";
+        std::cout.write(linea, longitud < 16 ? longitud : 16);
+        std::cout << "...] -> Procesando... -> ERROR: Trama mal formada (mas de " << longitud << " bytes).\n\n";
+    }
+    
+    return LINEA_INVALIDA;
+}
+
+/**
+ * @brief Procesa lo que entregó el lector según el modo en que está
+ * @param binaria true si datos es una trama binaria y no una línea
+ * @param truncada true si la línea no cupo en el buffer (ver VistaLinea)
+ */
+ResultadoLinea procesarEntrada(const char* datos, int longitud, bool binaria, bool truncada,
+                               ListaDeCarga& carga, RotorDeMapeo& rotor,
+                               const char* prefijo = nullptr,
+                               MetricasDecodificador* metricas = nullptr) {
+    if (truncada) return procesarLineaTruncada(datos, longitud, carga, prefijo, metricas);
+    
+    return binaria ? procesarTramaBinaria(datos, longitud, carga, rotor, prefijo, metricas)
+                   : procesarLinea(datos, longitud, carga, rotor, prefijo, metricas);
+}
+
+/**
+ * @brief Niveles de salida seleccionables con --verbosidad
+ */
+enum Verbosidad {
+    VERBOSIDAD_SILENCIO,    ///< Solo el mensaje ensamblado; std::cout queda silenciado
+    VERBOSIDAD_RESUMEN,     ///< Control, FIN y resultado final (IMPRESION_SILENCIOSA)
+    VERBOSIDAD_TRAMA        ///< Además, una salida por trama
+};
+
+/**
+ * @brief Imprime solo el mensaje, aunque std::cout esté silenciado
+ * @param prefijo Antepuesto al mensaje (p. ej. el puerto)
+ */
+void imprimirSoloMensaje(const ListaDeCarga& carga, const char* prefijo) {
+    std::ios::iostate estado = std::cout.rdstate();
+    std::cout.clear();
+    std::cout << prefijo;
+    carga.imprimirMensaje();
+    std::cout << '\n';
+    // Con failbit puesto, los flush() de los bucles de lectura no harían nada
+    std::cout.flush();
+    std::cout.setstate(estado);
+}
+
+/**
+ * @brief Imprime el bloque final con el mensaje ensamblado
+ * @param verbosidad Con VERBOSIDAD_SILENCIO se imprime solo el mensaje,
+ *        aunque std::cout esté silenciado
+ * @param prefijo Antepuesto al mensaje con VERBOSIDAD_SILENCIO (p. ej. el puerto)
+ */
+void imprimirResultadoFinal(const ListaDeCarga& carga, Verbosidad verbosidad = VERBOSIDAD_TRAMA,
+                            const char* prefijo = "") {
+    if (verbosidad == VERBOSIDAD_SILENCIO) {
+        imprimirSoloMensaje(carga, prefijo);
+        return;
+    }
+    
+    std::cout << "---\n";
+    std::cout << "Flujo de datos terminado.\n";
+    if (carga.getModoImpresion() != IMPRESION_COMPLETA) {
+        // Vista completa de fragmentos, una sola vez al final
+        carga.imprimirConFormato();
+        std::cout << '\n';
+    }
+    std::cout << "MENSAJE OCULTO ENSAMBLADO:\n";
+    carga.imprimirMensaje();
+    std::cout << '\n';
+    std::cout << "---\n";
+    std::cout << "Liberando memoria... Sistema apagado.\n";
+}
+
+/**
+ * @brief Qué hacer con cada mensaje al recibir su trama FIN
+ * * Sin modo continuo, la decodificación se detiene en el primer FIN y el
+ * mensaje se entrega al sumidero (si hay) al final. En modo continuo
+ * (--continuo), cada FIN cierra un ciclo: el mensaje se imprime y se
+ * entrega, la lista se vacía devolviendo sus nodos al pool y el rotor
+ * vuelve a su posición inicial; la lectura sigue. La memoria queda acotada
+ * por el mensaje más largo y no por el tiempo que lleve encendido.
+ */
+class CierreDeCiclo {
+private:
+    SumideroMensajes* sumidero;     // nullptr: solo consola
+    Verbosidad verbosidad;
+    bool continuo;
+    long long ciclos;
+    char* buffer;                   // Reutilizado entre ciclos
+    int capacidad;
+    
+public:
+    /**
+     * @param s Sumidero de los mensajes, o nullptr
+     * @param v Nivel de salida de cada ciclo
+     * @param c true para el modo continuo
+     */
+    CierreDeCiclo(SumideroMensajes* s, Verbosidad v, bool c)
+        : sumidero(s), verbosidad(v), continuo(c), ciclos(0), buffer(nullptr), capacidad(0) {}
+    
+    CierreDeCiclo(const CierreDeCiclo&) = delete;
+    CierreDeCiclo& operator=(const CierreDeCiclo&) = delete;
+    
+    ~CierreDeCiclo() {
+        delete[] buffer;
+    }
+    
+    bool esContinuo() const {
+        return continuo;
+    }
+    
+    long long getCiclos() const {
+        return ciclos;
+    }
+    
+    /**
+     * @brief Entrega el mensaje actual al sumidero, si hay uno
+     */
+    void entregar(const ListaDeCarga& carga, const char* prefijo = "") {
+        if (sumidero == nullptr) return;
+        
+        if (carga.getTamanio() > capacidad) {
+            delete[] buffer;
+            capacidad = carga.getTamanio();
+            buffer = new char[capacidad];
+        }
+        
+        int longitud = carga.copiarEn(buffer, capacidad);
+        if (!sumidero->entregar(buffer, longitud, prefijo)) {
+            std::cerr << prefijo << "ERROR: No se pudo entregar el mensaje al sumidero." << std::endl;
+        }
+    }
+    
+    /**
+     * @brief Cierra un ciclo del modo continuo y deja todo listo para el siguiente
+     */
+    void cerrar(ListaDeCarga& carga, RotorDeMapeo& rotor, const char* prefijo = "") {
+        ciclos++;
+        
+        if (verbosidad == VERBOSIDAD_SILENCIO) {
+            imprimirSoloMensaje(carga, prefijo);
+        } else {
+            std::cout << prefijo << "--- Ciclo " << ciclos << " terminado ---\n";
+            std::cout << prefijo << "MENSAJE OCULTO ENSAMBLADO: ";
+            carga.imprimirMensaje();
+            std::cout << "\n\n";
+        }
+        
+        entregar(carga, prefijo);
+        carga.vaciar();
+        rotor.reiniciar();
+    }
+};
+
+/**
+ * @brief Guarda y restaura el estado del decodificador entre arranques
+ * * Cada `cada` tramas LOAD/MAP, o `intervaloMs` después de la primera
+ * trama sin guardar, agrega al archivo un registro con los caracteres
+ * nuevos y el estado del rotor (ver serializarRegistroPuntoDeControl()):
+ * cada escritura cuesta O(caracteres nuevos), no O(mensaje). Cuando los
+ * registros ya ocupan más que la imagen, compacta: escribe la imagen
+ * completa (ver serializarPuntoDeControl()) en `<ruta>.tmp` y la renombra
+ * sobre `<ruta>`, así que la imagen siempre está completa; si el proceso
+ * muere a mitad de un registro, cargar() lo ignora. No se llama a fsync(),
+ * así que un corte de energía puede perder los últimos puntos de control.
+ * Al arrancar, cargar() deja el decodificador donde quedó, sin esperar el
+ * siguiente ciclo completo del emisor.
+ */
+class PuntoDeControl {
+public:
+    static const long MAX_BYTES = 256L * 1024 * 1024;   ///< Archivos más grandes se rechazan al cargar
+    static const int MIN_BYTES_COMPACTAR = 64 * 1024;   ///< Registros que se acumulan antes de compactar
+    
+private:
+    const char* ruta;
+    char rutaTemporal[512];
+    int cada;                       // Tramas entre escrituras
+    unsigned long long intervaloNs; // Tiempo máximo con tramas sin guardar
+    int pendientes;                 // Tramas aplicadas desde la última escritura
+    unsigned long long primeraPendienteNs;  // relojNs() de la primera de ellas
+    EstadoDeFlujo estado;
+    char* buffer;                   // Reutilizado entre escrituras
+    int capacidad;
+    std::FILE* diario;              // <ruta> abierto para agregar registros, o nullptr
+    int persistidos;                // Caracteres del mensaje ya en el archivo; -1 = sin imagen válida
+    long bytesImagen;               // Tamaño de la última imagen completa
+    long bytesRegistros;            // Registros agregados detrás de ella
+    bool avisado;                   // Ya se informó un error de escritura
+    
+public:
+    /**
+     * @param r Archivo del punto de control
+     * @param c Tramas entre escrituras (1 = después de cada trama)
+     * @param ms Milisegundos máximos entre la primera trama sin guardar y su escritura
+     */
+    PuntoDeControl(const char* r, int c, int ms)
+        : ruta(r), cada(c), intervaloNs((unsigned long long)ms * 1000000ULL), pendientes(0),
+          primeraPendienteNs(0), buffer(nullptr), capacidad(0), diario(nullptr), persistidos(-1),
+          bytesImagen(0), bytesRegistros(0), avisado(false) {
+        std::snprintf(rutaTemporal, sizeof(rutaTemporal), "%s.tmp", ruta);
+    }
+    
+    PuntoDeControl(const PuntoDeControl&) = delete;
+    PuntoDeControl& operator=(const PuntoDeControl&) = delete;
+    
+    ~PuntoDeControl() {
+        cerrarDiario();
+        delete[] buffer;
+    }
+    
+    const char* getRuta() const {
+        return ruta;
+    }
+    
+    unsigned long long getSecuencia() const {
+        return estado.secuencia;
+    }
+    
+    bool esBinario() const {
+        return estado.binario;
+    }
+    
+    /**
+     * @brief Anota que el emisor pasó a modo binario (se guarda en la siguiente escritura)
+     */
+    void setBinario(bool b) {
+        estado.binario = b;
+    }
+    
+    /**
+     * @brief Restaura el último punto de control, si hay uno válido
+     * * Si lo restaura, lo compacta de inmediato: un registro incompleto al
+     * final no debe quedar delante de los siguientes.
+     * @return false si no existe, pasa de MAX_BYTES o no corresponde a este
+     *        motor de rotor; en ese caso carga y rotor quedan como estaban
+     */
+    bool cargar(ListaDeCarga& carga, RotorDeMapeo& rotor) {
+        std::FILE* archivo = std::fopen(ruta, "rb");
+        if (archivo == nullptr) return false;
+        
+        bool valido = false;
+        if (std::fseek(archivo, 0, SEEK_END) == 0) {
+            long longitud = std::ftell(archivo);
+            if (longitud > 0 && longitud <= MAX_BYTES && std::fseek(archivo, 0, SEEK_SET) == 0) {
+                reservar((int)longitud);
+                valido = std::fread(buffer, 1, (size_t)longitud, archivo) == (size_t)longitud &&
+                         restaurarPuntoDeControl(buffer, (int)longitud, carga, rotor, estado);
+            }
+        }
+        std::fclose(archivo);
+        
+        if (valido) guardar(carga, rotor);
+        return valido;
+    }
+    
+    /**
+     * @brief Cuenta una trama LOAD/MAP aplicada y escribe si toca
+     * @param binario Si la trama llegó en modo binario
+     */
+    void registrarTrama(const ListaDeCarga& carga, const RotorDeMapeo& rotor, bool binario) {
+        estado.secuencia++;
+        estado.binario = binario;
+        if (pendientes++ == 0) {
+            primeraPendienteNs = relojNs();
+        }
+        if (pendientes >= cada || relojNs() - primeraPendienteNs >= intervaloNs) {
+            escribir(carga, rotor);
+        }
+    }
+    
+    /**
+     * @brief Escribe las tramas pendientes si ya pasó el intervalo
+     * * Para llamar mientras la fuente está ociosa: sin ella, las últimas
+     * tramas de una ráfaga esperarían a la siguiente.
+     */
+    void revisarTiempo(const ListaDeCarga& carga, const RotorDeMapeo& rotor) {
+        if (pendientes > 0 && relojNs() - primeraPendienteNs >= intervaloNs) {
+            escribir(carga, rotor);
+        }
+    }
+    
+    /**
+     * @brief Escribe la imagen completa del estado actual de inmediato
+     * @return false si no se pudo escribir o renombrar
+     */
+    bool guardar(const ListaDeCarga& carga, const RotorDeMapeo& rotor) {
+        pendientes = 0;
+        cerrarDiario();     // Después del rename, el diario abierto apuntaría al archivo viejo
+        reservar(tamanioPuntoDeControl<RotorDeMapeo>(carga));
+        int longitud = serializarPuntoDeControl(carga, rotor, estado, buffer, capacidad);
+        
+        std::FILE* archivo = std::fopen(rutaTemporal, "wb");
+        bool escrito = archivo != nullptr;
+        if (escrito) {
+            escrito = std::fwrite(buffer, 1, (size_t)longitud, archivo) == (size_t)longitud;
+            escrito = (std::fclose(archivo) == 0) && escrito;
+        }
+        
+        #ifdef _WIN32
+            escrito = escrito && MoveFileExA(rutaTemporal, ruta, MOVEFILE_REPLACE_EXISTING) != 0;
+        #else
+            escrito = escrito && std::rename(rutaTemporal, ruta) == 0;
+        #endif
+        
+        if (escrito) {
+            persistidos = carga.getTamanio();
+            bytesImagen = longitud;
+            bytesRegistros = 0;
+        } else {
+            persistidos = -1;
+            avisarError();
+        }
+        return escrito;
+    }
+    
+    /**
+     * @brief Borra el punto de control: el mensaje ya se entregó completo
+     */
+    void descartar() {
+        pendientes = 0;
+        cerrarDiario();
+        persistidos = -1;
+        std::remove(ruta);
+    }
+    
+private:
+    /**
+     * @brief Agrega un registro con lo nuevo desde la última escritura, o
+     *        compacta si los registros ya ocupan más que la imagen
+     */
+    void escribir(const ListaDeCarga& carga, const RotorDeMapeo& rotor) {
+        int nuevos = carga.getTamanio() - persistidos;
+        // Sin imagen válida o con el mensaje vaciado por fuera, solo sirve una imagen nueva
+        if (persistidos < 0 || nuevos < 0 ||
+            bytesRegistros > (bytesImagen > MIN_BYTES_COMPACTAR ? bytesImagen : MIN_BYTES_COMPACTAR)) {
+            guardar(carga, rotor);
+            return;
+        }
+        
+        pendientes = 0;
+        reservar(tamanioRegistroPuntoDeControl<RotorDeMapeo>(nuevos));
+        int longitud = serializarRegistroPuntoDeControl(carga, nuevos, rotor, estado, buffer, capacidad);
+        
+        if (diario == nullptr) diario = std::fopen(ruta, "ab");
+        bool escrito = diario != nullptr &&
+                       std::fwrite(buffer, 1, (size_t)longitud, diario) == (size_t)longitud &&
+                       std::fflush(diario) == 0;
+        
+        if (escrito) {
+            persistidos += nuevos;
+            bytesRegistros += longitud;
+        } else {
+            // Un registro a medias no puede quedar delante de otros: la próxima vez, imagen completa
+            cerrarDiario();
+            persistidos = -1;
+            avisarError();
+        }
+    }
+    
+    void cerrarDiario() {
+        if (diario != nullptr) {
+            std::fclose(diario);
+            diario = nullptr;
+        }
+    }
+    
+    void avisarError() {
+        if (!avisado) {
+            std::cerr << "ERROR: No se pudo escribir el punto de control " << ruta << "." << std::endl;
+            avisado = true;
+        }
+    }
+    
+    void reservar(int bytes) {
+        if (bytes > capacidad) {
+            delete[] buffer;
+            capacidad = bytes;
+            buffer = new char[capacidad];
+        }
+    }
+};
+
+/**
+ * @brief Decodifica en un solo hilo: leer, analizar, decodificar e imprimir
+ * @param metricas Instrumentación, o nullptr si está apagada
+ * @param cierre Con modo continuo, cada FIN cierra un ciclo en lugar de
+ *        detener la lectura; nullptr para detenerse en el primer FIN
+ * @return Cantidad de tramas LOAD/MAP aplicadas
+ */
+int decodificarSecuencial(FuenteDeDatos& fuente, ListaDeCarga& carga, RotorDeMapeo& rotor,
+                          MetricasDecodificador* metricas = nullptr, CierreDeCiclo* cierre = nullptr,
+                          PuntoDeControl* control = nullptr) {
+    LectorDeLineas lector(fuente);
+    VistaLinea linea;
+    int tramasRecibidas = 0;
+    
+    lector.setMedicion(metricas != nullptr);
+    if (control != nullptr && control->esBinario()) {
+        lector.setBinario(true);    // Se reanuda un flujo que ya estaba en modo binario
+    }
+    
+    while (true) {
+        bool hayDatos = lector.extraerLinea(linea);
+        
+        if (!hayDatos) {
+            // Antes de bloquearse en la fuente, mostrar lo acumulado
+            std::cout.flush();
+            hayDatos = lector.leerLinea(linea);
+        }
+        
+        if (metricas) {
+            metricas->bytesLeidos = lector.getBytesLeidos();
+            if (!hayDatos) metricas->revisarIntervalo();
+        }
+        if (!hayDatos && control) control->revisarTiempo(carga, rotor);
+        
+        if (!hayDatos && fuente.terminada()) {
+            std::cout << "Fin de la entrada.\n";
+            if (control) control->guardar(carga, rotor);
+            break;
+        }
+        
+        if (hayDatos) {
+            ResultadoLinea resultado = procesarEntrada(linea.datos, linea.longitud, lector.esBinario(),
+                                                       linea.truncada, carga, rotor, nullptr, metricas);
+            if (metricas) metricas->registrar(resultado, lector.getMarcaLectura());
+            
+            if (resultado == LINEA_FIN) {
+                if (cierre == nullptr || !cierre->esContinuo()) {
+                    if (control) control->descartar();
+                    break; // Salir del bucle while(true)
+                }
+                cierre->cerrar(carga, rotor);
+                if (control) control->guardar(carga, rotor);
+            }
+            if (resultado == LINEA_TRAMA) {
+                tramasRecibidas++;
+                if (control) control->registrarTrama(carga, rotor, lector.esBinario());
+            }
+            if (resultado == LINEA_BINARIO) {
+                lector.setBinario(true);
+                if (control) control->setBinario(true);
+            }
+        }
+    }
+    
+    return tramasRecibidas;
+}
+
+/**
+ * @brief Decodifica con un hilo de E/S y una cola SPSC de líneas
+ * * El hilo de E/S solo lee el puerto y copia cada línea en la cola, así
+ * que una consola lenta ya no detiene la lectura ni desborda el buffer de
+ * la UART. El hilo llamador es dueño de la ListaDeCarga y del RotorDeMapeo:
+ * analiza, decodifica e imprime. El hilo de E/S termina por su cuenta al
+ * reenviar la trama FIN o al agotarse la fuente.
+ * @param metricas Instrumentación, o nullptr si está apagada; la latencia
+ *        incluye el tiempo de espera en la cola
+ * @param cierre Como en decodificarSecuencial(); en modo continuo el hilo
+ *        de E/S sigue leyendo después de cada FIN
+ * @return Cantidad de tramas LOAD/MAP aplicadas
+ */
+int decodificarEnTuberia(FuenteDeDatos& fuente, ListaDeCarga& carga, RotorDeMapeo& rotor,
+                         MetricasDecodificador* metricas = nullptr, CierreDeCiclo* cierre = nullptr,
+                         PuntoDeControl* control = nullptr) {
+    static ColaSPSC<LineaCruda, 1024> cola;  // ~260 KiB: fuera de la pila
+    bool medicion = (metricas != nullptr);
+    bool continuo = (cierre != nullptr && cierre->esContinuo());
+    bool binario = (control != nullptr && control->esBinario());
+    
+    std::thread hiloES([&fuente, medicion, continuo, binario]() {
+        LectorDeLineas lector(fuente);
+        VistaLinea linea;
+        bool fin = false;
+        
+        lector.setMedicion(medicion);
+        lector.setBinario(binario);
+        
+        while (!fin) {
+            bool hayDatos = lector.leerLinea(linea);
+            
+            if (!hayDatos && !fuente.terminada()) continue;
+            
+            LineaCruda* destino;
+            int intentos = 0;
+            while ((destino = cola.reservar()) == nullptr) {
+                esperarConRetroceso(intentos);
+            }
+            
+            destino->bytesLeidos = lector.getBytesLeidos();
+            destino->recibidaNs = lector.getMarcaLectura();
+            
+            if (hayDatos) {
+                int n = linea.longitud < LineaCruda::MAX_LINEA - 1
+                      ? linea.longitud : LineaCruda::MAX_LINEA - 1;
+                std::memcpy(destino->datos, linea.datos, n);
+                destino->datos[n] = '\0';
+                destino->longitud = n;
+                destino->binaria = lector.esBinario();
+                destino->truncada = linea.truncada || n < linea.longitud;
+                
+                if (lector.esBinario()) {
+                    Trama trama;
+                    fin = !continuo && analizarTramaBinaria(linea.datos, linea.longitud, trama) &&
+                          trama.tipo == TRAMA_FIN;
+                } else if (!destino->truncada) {
+                    // Una línea truncada no se analiza: el consumidor la rechaza
+                    Trama trama;
+                    TipoTrama tipo = clasificarLinea(linea.datos, linea.longitud, trama);
+                    fin = !continuo && tipo == TRAMA_FIN;
+                    // El cambio de modo se aplica aquí, donde vive el lector
+                    if (tipo == TRAMA_MODO_BINARIO) {
+                        lector.setBinario(true);
+                    }
+                }
+            } else {
+                destino->longitud = -1;
+                fin = true;
+            }
+            
+            cola.publicar();
+        }
+    });
+    
+    int tramasRecibidas = 0;
+    
+    while (true) {
+        LineaCruda* linea;
+        int intentos = 0;
+        while ((linea = cola.frente()) == nullptr) {
+            if (intentos == 0) {
+                std::cout.flush();   // Cola vacía: mostrar lo acumulado
+                if (control) control->revisarTiempo(carga, rotor);
+            }
+            esperarConRetroceso(intentos);
+        }
+        
+        if (metricas) metricas->bytesLeidos = linea->bytesLeidos;
+        
+        if (linea->longitud < 0) {
+            cola.liberar();
+            std::cout << "Fin de la entrada.\n";
+            if (control) control->guardar(carga, rotor);
+            break;
+        }
+        
+        bool lineaBinaria = linea->binaria;
+        ResultadoLinea resultado = procesarEntrada(linea->datos, linea->longitud, lineaBinaria,
+                                                   linea->truncada, carga, rotor, nullptr, metricas);
+        if (metricas) metricas->registrar(resultado, linea->recibidaNs);
+        cola.liberar();
+        
+        if (resultado == LINEA_FIN) {
+            if (!continuo) {
+                if (control) control->descartar();
+                break;
+            }
+            cierre->cerrar(carga, rotor);
+            if (control) control->guardar(carga, rotor);
+        }
+        if (resultado == LINEA_TRAMA) {
+            tramasRecibidas++;
+            if (control) control->registrarTrama(carga, rotor, lineaBinaria);
+        }
+        if (resultado == LINEA_BINARIO && control) control->setBinario(true);
+    }
+    
+    hiloES.join();
+    return tramasRecibidas;
+}
+
+/**
+ * @brief Estado de decodificación de un dispositivo dentro del gestor
+ * * Cada puerto tiene su propio lector, su ListaDeCarga y su RotorDeMapeo.
+ */
+struct SesionPuerto {
+    const char* nombre;
+    char prefijo[64];   ///< "[nombre] " para marcar la salida de la sesión
+    FuenteSerial fuente;
+    LectorDeLineas lector;
+    ListaDeCarga carga;
+    RotorDeMapeo rotor;
+    bool activa;
+    #ifdef _WIN32
+        OVERLAPPED lectura;
+        char bufferLectura[1024];
+    #endif
+    
+    SesionPuerto(const char* n, Descriptor d, const ConfiguracionPuerto& config, ModoImpresion modo)
+        : nombre(n), fuente(d, config), lector(fuente), carga(modo), activa(true) {
+        std::snprintf(prefijo, sizeof(prefijo), "[%s] ", n);
+    }
+};
+
+/**
+ * @brief Decodifica varios puertos seriales a la vez desde un solo hilo
+ * * Abre todos los puertos configurados y los multiplexa con poll() en
+ * Linux/Mac o con lecturas superpuestas (overlapped) y
+ * WaitForMultipleObjects() en Windows. Cada sesión termina al recibir su
+ * FIN (en modo continuo, solo cierra un ciclo) o al cerrarse su puerto; el
+ * gestor termina cuando no queda ninguna.
+ */
+class GestorDeSesiones {
+public:
+    #ifdef _WIN32
+        static const int MAX_SESIONES = MAXIMUM_WAIT_OBJECTS;
+    #else
+        static const int MAX_SESIONES = 64;
+    #endif
+    
+private:
+    SesionPuerto* sesiones[MAX_SESIONES];
+    int cantidad;
+    int activas;
+    MetricasDecodificador* metricas;   // Compartidas por todas las sesiones
+    Verbosidad verbosidad;
+    CierreDeCiclo* cierre;
+    
+    /**
+     * @brief Procesa todas las líneas completas que tenga una sesión
+     */
+    void procesarPendientes(SesionPuerto& sesion) {
+        VistaLinea linea;
+        
+        while (sesion.activa && sesion.lector.extraerLinea(linea)) {
+            ResultadoLinea resultado = procesarEntrada(linea.datos, linea.longitud,
+                                                       sesion.lector.esBinario(), linea.truncada,
+                                                       sesion.carga, sesion.rotor, sesion.prefijo,
+                                                       metricas);
+            if (metricas) metricas->registrar(resultado, sesion.lector.getMarcaLectura());
+            
+            if (resultado == LINEA_FIN) {
+                if (cierre != nullptr && cierre->esContinuo()) {
+                    cierre->cerrar(sesion.carga, sesion.rotor, sesion.prefijo);
+                } else {
+                    finalizar(sesion);
+                }
+            } else if (resultado == LINEA_BINARIO) {
+                sesion.lector.setBinario(true);
+            }
+        }
+    }
+    
+    /**
+     * @brief Cierra una sesión e imprime su mensaje ensamblado
+     */
+    void finalizar(SesionPuerto& sesion) {
+        if (!sesion.activa) return;
+        
+        sesion.activa = false;
+        activas--;
+        #ifdef _WIN32
+            CancelIo(sesion.fuente.getDescriptor());
+            CloseHandle(sesion.lectura.hEvent);
+        #endif
+        
+        if (metricas) metricas->registrarEnlace(sesion.fuente.getEnlace());
+        
+        std::cout << "=== Puerto " << sesion.nombre << " ===\n";
+        imprimirResultadoFinal(sesion.carga, verbosidad, sesion.prefijo);
+        if (cierre != nullptr && !cierre->esContinuo()) {
+            cierre->entregar(sesion.carga, sesion.prefijo);
+        }
+    }
+    
+    #ifdef _WIN32
+    /**
+     * @brief Inicia una lectura superpuesta en la sesión
+     * @return false si el puerto falló
+     */
+    bool iniciarLectura(SesionPuerto& sesion) {
+        ResetEvent(sesion.lectura.hEvent);
+        
+        if (!ReadFile(sesion.fuente.getDescriptor(), sesion.bufferLectura,
+                      sizeof(sesion.bufferLectura), NULL, &sesion.lectura)) {
+            return GetLastError() == ERROR_IO_PENDING;
+        }
+        
+        return true; // Completó de inmediato; el evento ya quedó señalado
+    }
+    #endif
+    
+public:
+    /**
+     * @param m Instrumentación, o nullptr si está apagada
+     * @param v Nivel de salida del resultado de cada sesión
+     * @param c Cierre de ciclo compartido por las sesiones, o nullptr
+     */
+    GestorDeSesiones(MetricasDecodificador* m = nullptr, Verbosidad v = VERBOSIDAD_TRAMA,
+                     CierreDeCiclo* c = nullptr)
+        : cantidad(0), activas(0), metricas(m), verbosidad(v), cierre(c) {}
+    
+    GestorDeSesiones(const GestorDeSesiones&) = delete;
+    GestorDeSesiones& operator=(const GestorDeSesiones&) = delete;
+    
+    ~GestorDeSesiones() {
+        for (int i = 0; i < cantidad; i++) {
+            delete sesiones[i];
+        }
+    }
+    
+    /**
+     * @brief Abre un puerto y crea su sesión
+     * @param config Velocidad y control de flujo con los que se abre el
+     *        puerto (compartidos por todas las sesiones)
+     * @return false si no se pudo abrir o ya no caben más sesiones
+     */
+    bool agregar(const char* puerto, ModoImpresion modo, const ConfiguracionPuerto& config) {
+        if (cantidad == MAX_SESIONES) return false;
+        
+        #ifdef _WIN32
+            Descriptor d = abrirPuertoSerial(puerto, config, true);
+        #else
+            Descriptor d = abrirPuertoSerial(puerto, config);
+        #endif
+        if (d == DESCRIPTOR_INVALIDO) return false;
+        
+        SesionPuerto* sesion = new SesionPuerto(puerto, d, config, modo);
+        sesion->lector.setMedicion(metricas != nullptr);
+        #ifdef _WIN32
+            ZeroMemory(&sesion->lectura, sizeof(sesion->lectura));
+            sesion->lectura.hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+        #endif
+        
+        sesiones[cantidad++] = sesion;
+        activas++;
+        std::cout << "Conexion establecida en " << puerto << '\n';
+        return true;
+    }
+    
+    /**
+     * @brief Atiende todos los puertos hasta que terminen sus sesiones
+     */
+    void ejecutar() {
+        #ifdef _WIN32
+            for (int i = 0; i < cantidad; i++) {
+                if (!iniciarLectura(*sesiones[i])) {
+                    finalizar(*sesiones[i]);
+                }
+            }
+            
+            while (activas > 0) {
+                HANDLE eventos[MAX_SESIONES];
+                SesionPuerto* duenos[MAX_SESIONES];
+                DWORD n = 0;
+                
+                for (int i = 0; i < cantidad; i++) {
+                    if (sesiones[i]->activa) {
+                        duenos[n] = sesiones[i];
+                        eventos[n++] = sesiones[i]->lectura.hEvent;
+                    }
+                }
+                
+                std::cout.flush();   // Nada pendiente: mostrar lo acumulado antes de esperar
+                DWORD r = WaitForMultipleObjects(n, eventos, FALSE, INFINITE);
+                if (r >= WAIT_OBJECT_0 + n) break;
+                
+                SesionPuerto& sesion = *duenos[r - WAIT_OBJECT_0];
+                DWORD leidos = 0;
+                
+                if (!GetOverlappedResult(sesion.fuente.getDescriptor(), &sesion.lectura, &leidos, FALSE)) {
+                    finalizar(sesion);
+                    continue;
+                }
+                
+                // Un timeout completa con 0 bytes: simplemente se relanza
+                sesion.fuente.revisarEnlace();
+                if (metricas) metricas->bytesLeidos += leidos;
+                int copiados = 0;
+                while (sesion.activa && copiados < (int)leidos) {
+                    copiados += sesion.lector.agregar(sesion.bufferLectura + copiados, (int)leidos - copiados);
+                    procesarPendientes(sesion);
+                }
+                
+                if (sesion.activa && !iniciarLectura(sesion)) {
+                    finalizar(sesion);
+                }
+            }
+        #else
+            while (activas > 0) {
+                struct pollfd fds[MAX_SESIONES];
+                SesionPuerto* duenos[MAX_SESIONES];
+                nfds_t n = 0;
+                
+                for (int i = 0; i < cantidad; i++) {
+                    if (sesiones[i]->activa) {
+                        duenos[n] = sesiones[i];
+                        fds[n].fd = sesiones[i]->fuente.getDescriptor();
+                        fds[n].events = POLLIN;
+                        fds[n].revents = 0;
+                        n++;
+                    }
+                }
+                
+                std::cout.flush();   // Nada pendiente: mostrar lo acumulado antes de esperar
+                if (poll(fds, n, -1) < 0) break;
+                
+                for (nfds_t i = 0; i < n; i++) {
+                    if (fds[i].revents == 0) continue;
+                    
+                    SesionPuerto& sesion = *duenos[i];
+                    int leidos = sesion.lector.rellenar();
+                    
+                    if (leidos <= 0) {
+                        // Puerto cerrado o con error: cerrar su sesión
+                        finalizar(sesion);
+                        continue;
+                    }
+                    
+                    if (metricas) metricas->bytesLeidos += leidos;
+                    
+                    procesarPendientes(sesion);
+                }
+            }
+        #endif
+    }
+};
+
+/**
+ * @brief Decodifica una captura completa proyectada en memoria
+ * @param hilos Hilos para decodificarParalelo() (1 = una sola pasada)
+ * @param metricas Recibe los contadores del lote, o nullptr; el lote no
+ *        mide tiempos por trama
+ * @param cierre Con modo continuo, la captura se recorre ciclo a ciclo
+ *        hasta el final; nullptr para detenerse en el primer FIN
+ * @return Código de salida del programa
+ */
+int decodificarArchivoMapeado(const char* ruta, ListaDeCarga& carga, RotorDeMapeo& rotor, int hilos,
+                              MetricasDecodificador* metricas = nullptr, CierreDeCiclo* cierre = nullptr) {
+    std::cout << "Iniciando Decodificador PRT-7. Proyectando " << ruta << " en memoria...\n";
+    
+    ArchivoMapeado archivo;
+    if (!archivo.abrir(ruta)) {
+        std::cerr << "ERROR: No se pudo proyectar " << ruta << "." << std::endl;
+        return 1;
+    }
+    
+    EstadisticasLote stats;
+    size_t pos = 0;
+    
+    while (true) {
+        const char* datos = archivo.getDatos() + pos;
+        size_t restantes = archivo.getTamanio() - pos;
+        EstadisticasLote ciclo = (hilos == 1)
+            ? decodificarLote(datos, restantes, carga, rotor)
+            : decodificarParalelo(datos, restantes, carga, rotor, hilos);
+        
+        stats.lineas += ciclo.lineas;
+        stats.tramasLoad += ciclo.tramasLoad;
+        stats.tramasMap += ciclo.tramasMap;
+        stats.malformadas += ciclo.malformadas;
+        stats.control += ciclo.control;
+        stats.finEncontrado = ciclo.finEncontrado;
+        pos += ciclo.bytesConsumidos;
+        stats.bytesConsumidos = pos;
+        
+        if (!ciclo.finEncontrado || cierre == nullptr || !cierre->esContinuo()) break;
+        
+        cierre->cerrar(carga, rotor);
+        stats.finEncontrado = false;    // El último ciclo no terminó en FIN
+        if (pos >= archivo.getTamanio()) break;
+    }
+    
+    if (metricas) {
+        metricas->tramas = stats.tramasLoad + stats.tramasMap;
+        metricas->malformadas = stats.malformadas;
+        metricas->control = stats.control;
+        metricas->bytesLeidos = stats.bytesConsumidos;
+    }
     
-    // Mostrar resultado final
-    std::cout << "---" << std::endl;
-    std::cout << "Flujo de datos terminado." << std::endl;
-    std::cout << "MENSAJE OCULTO ENSAMBLADO:" << std::endl;
-    miListaDeCarga.imprimirMensaje();
-    std::cout << std::endl;
-    std::cout << "---" << std::endl;
-    std::cout << "Liberando memoria... Sistema apagado." << std::endl;
+    std::cout << "Tramas LOAD: " << stats.tramasLoad
+              << " | Tramas MAP: " << stats.tramasMap
+              << " | Mal formadas: " << stats.malformadas << '\n';
+    if (stats.finEncontrado) {
+        std::cout << "Trama recibida: [FIN]. Deteniendo.\n";
+    } else {
+        std::cout << "Fin de la entrada.\n";
+    }
     
     return 0;
+}
+
+/**
+ * @brief Buffer grande para std::cout mientras viva el objeto
+ * * Con '\n' en lugar de std::endl, la salida se acumula aquí y se escribe
+ * en bloques de CAPACIDAD bytes; los bucles de lectura la vacían con
+ * std::cout.flush() antes de esperar datos, así la consola sigue al día.
+ * Al destruirse vacía lo pendiente y devuelve a std::cout su buffer original.
+ */
+class BufferDeSalida : public std::streambuf {
+private:
+    static const int CAPACIDAD = 64 * 1024;
+    
+    char datos[CAPACIDAD];
+    std::streambuf* anterior;
+    
+    /**
+     * @brief Escribe lo acumulado en la salida estándar
+     * @return 0 si se escribió todo, -1 si hubo error
+     */
+    int vaciar() {
+        size_t pendientes = (size_t)(pptr() - pbase());
+        setp(datos, datos + CAPACIDAD);
+        
+        if (pendientes > 0 && std::fwrite(datos, 1, pendientes, stdout) != pendientes) {
+            return -1;
+        }
+        return std::fflush(stdout) == 0 ? 0 : -1;
+    }
+    
+protected:
+    int_type overflow(int_type c) override {
+        if (vaciar() != 0) return traits_type::eof();
+        
+        if (!traits_type::eq_int_type(c, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(c);
+            pbump(1);
+        }
+        return traits_type::not_eof(c);
+    }
+    
+    /**
+     * @brief Las escrituras grandes (p. ej. el mensaje final) van directo a
+     *        stdout después de vaciar lo acumulado, sin copiarse al buffer
+     */
+    std::streamsize xsputn(const char* s, std::streamsize n) override {
+        if (n < (std::streamsize)(epptr() - pptr())) {
+            std::memcpy(pptr(), s, (size_t)n);
+            pbump((int)n);
+            return n;
+        }
+        
+        if (vaciar() != 0) return 0;
+        return (std::streamsize)std::fwrite(s, 1, (size_t)n, stdout);
+    }
+    
+    int sync() override {
+        return vaciar();
+    }
+    
+public:
+    BufferDeSalida() {
+        setp(datos, datos + CAPACIDAD);
+        anterior = std::cout.rdbuf(this);
+    }
+    
+    BufferDeSalida(const BufferDeSalida&) = delete;
+    BufferDeSalida& operator=(const BufferDeSalida&) = delete;
+    
+    ~BufferDeSalida() override {
+        vaciar();
+        std::cout.rdbuf(anterior);
+    }
+};
+
+/**
+ * @brief Función principal del decodificador PRT-7
+ * * Opciones:
+ * - `--incremental`: cada trama LOAD imprime solo su fragmento.
+ * - `--silencioso`: no imprime nada por trama; solo el resultado final
+ *   (equivale a `--verbosidad resumen`).
+ * - `--verbosidad <silencio|resumen|trama>`: nivel de salida (ver
+ *   Verbosidad); `silencio` imprime únicamente el mensaje ensamblado.
+ * - `--archivo <ruta>`: lee las tramas de un archivo de captura en lugar
+ *   del puerto serial ("-" para la entrada estándar).
+ * - `--stdin`: equivalente a `--archivo -`.
+ * - `--mmap <ruta>`: proyecta la captura en memoria y la decodifica de
+ *   una sola pasada con decodificarLote(), sin salida por trama.
+ * - `--hilos <n>`: con `--mmap`, decodifica en paralelo con n hilos
+ *   (0 = todos los núcleos).
+ * - `--tuberia`: lee en un hilo de E/S separado del hilo que decodifica
+ *   e imprime, comunicados por una cola SPSC sin bloqueos.
+ * - `--puerto <ruta>`: usa ese puerto en lugar de buscar uno conocido. Se
+ *   puede repetir: con varios puertos, GestorDeSesiones decodifica todos a
+ *   la vez, cada uno con su propia lista y rotor.
+ * - `--baudios <n>`: velocidad del puerto (9600 por omisión); en Linux se
+ *   aceptan también velocidades no estándar.
+ * - `--timeout <ms>`: espera máxima de cada lectura del puerto.
+ * - `--flujo <ninguno|rtscts|xonxoff>`: control de flujo con el que se
+ *   frena al emisor cuando el decodificador se atrasa, en lugar de perder
+ *   bytes (ver FuenteSerial::revisarEnlace()).
+ * - `--config <ruta>`: lee puerto, baudios, timeout y flujo de un archivo (ver
+ *   cargarConfiguracion()). Las opciones posteriores en la línea de
+ *   comandos prevalecen sobre el archivo.
+ * - `--stats`: al terminar, imprime en stderr contadores, tramas/s y
+ *   histogramas de latencia (ver MetricasDecodificador).
+ * - `--stats-cada <s>`: además, una línea de estadísticas cada s segundos.
+ * - `--continuo`: cada FIN cierra un ciclo (mensaje impreso y entregado,
+ *   lista vaciada, rotor reiniciado) y la lectura continúa (ver
+ *   CierreDeCiclo).
+ * - `--sumidero <ruta | fd:N>`: agrega cada mensaje ensamblado, uno por
+ *   línea, al archivo indicado o (Linux/Mac) al descriptor heredado N.
+ */
+int main(int argc, char* argv[]) {
+    // Sin sincronizar con stdio y con buffer propio: cada '\n' ya no vacía
+    std::ios::sync_with_stdio(false);
+    BufferDeSalida bufferSalida;
+    
+    ModoImpresion modo = IMPRESION_COMPLETA;
+    Verbosidad verbosidad = VERBOSIDAD_TRAMA;
+    const char* rutaArchivo = nullptr;
+    const char* rutaMapeada = nullptr;
+    int hilos = 1;
+    bool tuberia = false;
+    const char* puertos[GestorDeSesiones::MAX_SESIONES];
+    int cantidadPuertos = 0;
+    ConfiguracionPuerto configPuerto;
+    bool estadisticas = false;
+    int statsCada = 0;
+    bool continuo = false;
+    const char* destinoSumidero = nullptr;
+    const char* rutaControl = nullptr;
+    int controlCada = 1000;
+    int controlMs = 100;
+    
+    for (int i = 1; i < argc; i++) {
+        if (sonIguales(argv[i], "--incremental")) {
+            modo = IMPRESION_INCREMENTAL;
+            verbosidad = VERBOSIDAD_TRAMA;
+        } else if (sonIguales(argv[i], "--silencioso")) {
+            verbosidad = VERBOSIDAD_RESUMEN;
+        } else if (sonIguales(argv[i], "--verbosidad") && i + 1 < argc) {
+            i++;
+            if (sonIguales(argv[i], "silencio")) {
+                verbosidad = VERBOSIDAD_SILENCIO;
+            } else if (sonIguales(argv[i], "resumen")) {
+                verbosidad = VERBOSIDAD_RESUMEN;
+            } else if (sonIguales(argv[i], "trama")) {
+                verbosidad = VERBOSIDAD_TRAMA;
+            } else {
+                std::cerr << "ERROR: Verbosidad invalida: " << argv[i]
+                          << " (silencio, resumen o trama)." << std::endl;
+                return 1;
+            }
+        } else if (sonIguales(argv[i], "--archivo") && i + 1 < argc) {
+            rutaArchivo = argv[++i];
+        } else if (sonIguales(argv[i], "--stdin")) {
+            rutaArchivo = "-";
+        } else if (sonIguales(argv[i], "--mmap") && i + 1 < argc) {
+            rutaMapeada = argv[++i];
+        } else if (sonIguales(argv[i], "--puerto") && i + 1 < argc) {
+            if (cantidadPuertos == GestorDeSesiones::MAX_SESIONES) {
+                std::cerr << "ERROR: Demasiados puertos (maximo "
+                          << GestorDeSesiones::MAX_SESIONES << ")." << std::endl;
+                return 1;
+            }
+            puertos[cantidadPuertos++] = argv[++i];
+        } else if (sonIguales(argv[i], "--tuberia")) {
+            tuberia = true;
+        } else if (sonIguales(argv[i], "--hilos") && i + 1 < argc) {
+            hilos = aEntero(argv[i + 1], (int)std::strlen(argv[i + 1]));
+            i++;
+        } else if (sonIguales(argv[i], "--baudios") && i + 1 < argc) {
+            configPuerto.baudios = aEntero(argv[i + 1], (int)std::strlen(argv[i + 1]));
+            i++;
+            if (configPuerto.baudios <= 0) {
+                std::cerr << "ERROR: Velocidad invalida: " << argv[i] << "." << std::endl;
+                return 1;
+            }
+        } else if (sonIguales(argv[i], "--timeout") && i + 1 < argc) {
+            configPuerto.timeoutMs = aEntero(argv[i + 1], (int)std::strlen(argv[i + 1]));
+            i++;
+            if (configPuerto.timeoutMs <= 0) {
+                std::cerr << "ERROR: Timeout invalido: " << argv[i] << "." << std::endl;
+                return 1;
+            }
+        } else if (sonIguales(argv[i], "--flujo") && i + 1 < argc) {
+            if (!leerControlDeFlujo(argv[++i], configPuerto.flujo)) {
+                std::cerr << "ERROR: Control de flujo invalido: " << argv[i]
+                          << " (ninguno, rtscts o xonxoff)." << std::endl;
+                return 1;
+            }
+        } else if (sonIguales(argv[i], "--stats")) {
+            estadisticas = true;
+        } else if (sonIguales(argv[i], "--stats-cada") && i + 1 < argc) {
+            statsCada = aEntero(argv[i + 1], (int)std::strlen(argv[i + 1]));
+            i++;
+            estadisticas = true;
+            if (statsCada <= 0) {
+                std::cerr << "ERROR: Intervalo invalido: " << argv[i] << "." << std::endl;
+                return 1;
+            }
+        } else if (sonIguales(argv[i], "--continuo")) {
+            continuo = true;
+        } else if (sonIguales(argv[i], "--sumidero") && i + 1 < argc) {
+            destinoSumidero = argv[++i];
+        } else if (sonIguales(argv[i], "--checkpoint") && i + 1 < argc) {
+            rutaControl = argv[++i];
+        } else if (sonIguales(argv[i], "--checkpoint-cada") && i + 1 < argc) {
+            controlCada = aEntero(argv[i + 1], (int)std::strlen(argv[i + 1]));
+            i++;
+            if (controlCada <= 0) {
+                std::cerr << "ERROR: Intervalo de checkpoint invalido: " << argv[i] << "." << std::endl;
+                return 1;
+            }
+        } else if (sonIguales(argv[i], "--checkpoint-ms") && i + 1 < argc) {
+            controlMs = aEntero(argv[i + 1], (int)std::strlen(argv[i + 1]));
+            i++;
+            if (controlMs <= 0) {
+                std::cerr << "ERROR: Intervalo de checkpoint invalido: " << argv[i] << "." << std::endl;
+                return 1;
+            }
+        } else if (sonIguales(argv[i], "--config") && i + 1 < argc) {
+            if (!cargarConfiguracion(argv[++i], configPuerto)) {
+                return 1;
+            }
+        } else {
+            std::cerr << "Opcion desconocida: " << argv[i] << std::endl;
+            std::cerr << "Uso: " << argv[0]
+                      << " [--incremental | --silencioso | --verbosidad <nivel>] [--tuberia] [--puerto <ruta>]..."
+                      << " [--baudios <n>] [--timeout <ms>] [--flujo <modo>] [--config <ruta>]"
+                      << " [--stats] [--stats-cada <s>] [--continuo] [--sumidero <ruta | fd:N>]"
+                      << " [--checkpoint <ruta> [--checkpoint-cada <n>] [--checkpoint-ms <ms>]]"
+                      << " [--archivo <ruta> | --stdin | --mmap <ruta> [--hilos <n>]]" << std::endl;
+            return 1;
+        }
+    }
+    
+    if (rutaControl != nullptr && (rutaMapeada != nullptr || cantidadPuertos > 1)) {
+        std::cerr << "ERROR: --checkpoint solo se admite con un puerto, --archivo o --stdin." << std::endl;
+        return 1;
+    }
+    
+    if (verbosidad != VERBOSIDAD_TRAMA) {
+        modo = IMPRESION_SILENCIOSA;
+    }
+    if (verbosidad == VERBOSIDAD_SILENCIO) {
+        // Todas las salidas se descartan sin formatearse; el mensaje final
+        // se imprime con imprimirResultadoFinal()
+        std::cout.setstate(std::ios::failbit);
+    }
+    
+    SumideroMensajes* sumidero = nullptr;
+    if (destinoSumidero != nullptr) {
+        if (std::strncmp(destinoSumidero, "fd:", 3) == 0) {
+            #ifdef _WIN32
+                std::cerr << "ERROR: --sumidero fd:N no esta disponible en Windows." << std::endl;
+                return 1;
+            #else
+                // Un socket cerrado por el otro extremo debe dar error, no terminar el proceso
+                signal(SIGPIPE, SIG_IGN);
+                sumidero = new SumideroDescriptor(aEntero(destinoSumidero + 3,
+                                                          (int)std::strlen(destinoSumidero + 3)));
+            #endif
+        } else {
+            std::FILE* archivo = std::fopen(destinoSumidero, "ab");
+            if (archivo == nullptr) {
+                std::cerr << "ERROR: No se pudo abrir el sumidero " << destinoSumidero << "." << std::endl;
+                return 1;
+            }
+            sumidero = new SumideroArchivo(archivo, true);
+        }
+    }
+    CierreDeCiclo cierre(sumidero, verbosidad, continuo);
+    
+    // El puerto del archivo de configuración solo se usa si no se dio --puerto
+    if (cantidadPuertos == 0 && configPuerto.dispositivo[0] != '\0') {
+        puertos[cantidadPuertos++] = configPuerto.dispositivo;
+    }
+    
+    std::cout << "========================================\n";
+    std::cout << "   DECODIFICADOR PRT-7 v1.0\n";
+    std::cout << "   Sistema de Ciberseguridad Industrial\n";
+    std::cout << "========================================\n";
+    std::cout << '\n';
+    
+    // Inicializar estructuras
+    ListaDeCarga miListaDeCarga(modo);
+    RotorDeMapeo miRotorDeMapeo;
+    
+    MetricasDecodificador metricas;
+    MetricasDecodificador* medicion = estadisticas ? &metricas : nullptr;
+    if (statsCada > 0) {
+        metricas.setIntervalo(statsCada);
+    }
+    
+    if (rutaMapeada != nullptr) {
+        int codigo = decodificarArchivoMapeado(rutaMapeada, miListaDeCarga, miRotorDeMapeo, hilos, medicion,
+                                               &cierre);
+        if (codigo == 0) {
+            if (!continuo || verbosidad != VERBOSIDAD_SILENCIO || miListaDeCarga.getTamanio() > 0) {
+                imprimirResultadoFinal(miListaDeCarga, verbosidad);
+            }
+            if (!continuo) cierre.entregar(miListaDeCarga);
+            if (medicion) metricas.imprimirResumen();
+        }
+        delete sumidero;
+        return codigo;
+    }
+    
+    if (cantidadPuertos > 1) {
+        std::cout << "Iniciando Decodificador PRT-7. Conectando a " << cantidadPuertos
+                  << " puertos...\n";
+        
+        GestorDeSesiones gestor(medicion, verbosidad, &cierre);
+        for (int i = 0; i < cantidadPuertos; i++) {
+            if (!gestor.agregar(puertos[i], modo, configPuerto)) {
+                std::cerr << "ERROR: No se pudo conectar a " << puertos[i] << "." << std::endl;
+                delete sumidero;
+                return 1;
+            }
+        }
+        
+        std::cout << "Esperando tramas...\n\n";
+        gestor.ejecutar();
+        if (medicion) metricas.imprimirResumen();
+        delete sumidero;
+        return 0;
+    }
+    
+    FuenteDeDatos* fuente = nullptr;
+    
+    if (rutaArchivo != nullptr) {
+        std::cout << "Iniciando Decodificador PRT-7. Leyendo tramas de "
+                  << (rutaArchivo[0] == '-' && rutaArchivo[1] == '\0' ? "la entrada estandar" : rutaArchivo)
+                  << "...\n";
+        
+        Descriptor d = abrirArchivoLectura(rutaArchivo);
+        if (d == DESCRIPTOR_INVALIDO) {
+            std::cerr << "ERROR: No se pudo abrir " << rutaArchivo << "." << std::endl;
+            delete sumidero;
+            return 1;
+        }
+        fuente = new FuenteArchivo(d);
+    } else {
+        std::cout << "Iniciando Decodificador PRT-7. Conectando a puerto COM...\n";
+        
+        // Intentar abrir puerto serial
+        fuente = conectarPuertoSerial(cantidadPuertos == 1 ? puertos[0] : nullptr, configPuerto);
+        if (fuente == nullptr) {
+            std::cerr << "ERROR: No se pudo conectar a ningun puerto serial." << std::endl;
+            std::cerr << "Verifique que el Arduino este conectado." << std::endl;
+            delete sumidero;
+            return 1;
+        }
+    }
+    
+    PuntoDeControl* control = nullptr;
+    if (rutaControl != nullptr) {
+        control = new PuntoDeControl(rutaControl, controlCada, controlMs);
+        
+        unsigned long long inicio = relojNs();
+        if (control->cargar(miListaDeCarga, miRotorDeMapeo)) {
+            std::cout << "Punto de control restaurado: secuencia " << control->getSecuencia() << ", "
+                      << miListaDeCarga.getTamanio() << " caracteres, rotor +"
+                      << miRotorDeMapeo.getDesplazamiento() << " (";
+            imprimirDuracion(std::cout, relojNs() - inicio);
+            std::cout << ")\n";
+        } else {
+            std::FILE* previo = std::fopen(rutaControl, "rb");
+            if (previo != nullptr) {
+                std::fclose(previo);
+                std::cerr << "AVISO: " << rutaControl
+                          << " no es un punto de control valido para este motor; se empieza de cero." << std::endl;
+            }
+        }
+    }
+    
+    std::cout << "Esperando tramas...\n\n";
+    
+    // Bucle de procesamiento
+    if (tuberia) {
+        decodificarEnTuberia(*fuente, miListaDeCarga, miRotorDeMapeo, medicion, &cierre, control);
+    } else {
+        decodificarSecuencial(*fuente, miListaDeCarga, miRotorDeMapeo, medicion, &cierre, control);
+    }
+    
+    // Cerrar puerto o archivo
+    if (medicion) metricas.registrarEnlace(fuente->getEnlace());
+    bool fallida = fuente->fallida();
+    delete fuente;
+    delete control;
+    
+    // Mostrar resultado final (en modo continuo y silencio, solo si quedó un ciclo a medias)
+    if (!continuo || verbosidad != VERBOSIDAD_SILENCIO || miListaDeCarga.getTamanio() > 0) {
+        imprimirResultadoFinal(miListaDeCarga, verbosidad);
+    }
+    if (!continuo) cierre.entregar(miListaDeCarga);
+    delete sumidero;
+    
+    if (medicion) metricas.imprimirResumen();
+    
+    return fallida ? 1 : 0;
 }
\ No newline at end of file
@@ -0,0 +1,2592 @@
+/**
+ * @file decodificador_prt7.h
+ * @brief Núcleo del decodificador de protocolo PRT-7
+ * @author Sistema de Ciberseguridad Industrial
+ * @date 2025
+ * * Contiene las estructuras de datos (rotores y lista de carga), la
+ * jerarquía de tramas y el análisis/decodificación de líneas. No depende
+ * del puerto serial, por lo que lo comparten el ejecutable y el banco de
+ * pruebas de rendimiento.
+ */
+
+#ifndef DECODIFICADOR_PRT7_H
+#define DECODIFICADOR_PRT7_H
+
+#include <iostream>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define PRT7_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #include <arm_neon.h>
+#endif
+
+/**
+ * @brief Nodo para la lista circular del rotor de mapeo
+ */
+struct NodoRotor {
+    char dato;
+    NodoRotor* siguiente;
+    NodoRotor* previo;
+    
+    NodoRotor(char c) : dato(c), siguiente(nullptr), previo(nullptr) {}
+};
+/**
+ * @brief Nodo para la lista doblemente enlazada de caracteres decodificados
+ */
+struct NodoCarga {
+    char dato;
+    NodoCarga* siguiente;
+    NodoCarga* previo;
+    
+    NodoCarga(char c = '\0') : dato(c), siguiente(nullptr), previo(nullptr) {}
+};
+/**
+ * @brief Almacén de nodos de carga reservados en bloques contiguos
+ * * En lugar de un new por carácter, reserva bloques de NODOS_POR_BLOQUE
+ * nodos y los entrega en orden. Los nodos consecutivos quedan contiguos en
+ * memoria y la liberación es un delete por bloque.
+ */
+class PoolDeNodos {
+private:
+    static const int NODOS_POR_BLOQUE = 1024;
+    
+    struct Bloque {
+        NodoCarga nodos[NODOS_POR_BLOQUE];
+        Bloque* siguiente;
+        
+        Bloque() : siguiente(nullptr) {}
+    };
+    
+    Bloque* primero;    // Primer bloque reservado
+    Bloque* ultimo;     // Último bloque de la cadena (para absorber() en O(1))
+    Bloque* actual;     // Bloque del que se toman nodos
+    int usados;         // Nodos entregados del bloque actual
+    
+    /**
+     * @brief Pasa al siguiente bloque, reservándolo solo si no hay uno reciclado
+     */
+    void abrirBloque() {
+        if (actual != nullptr && actual->siguiente != nullptr) {
+            actual = actual->siguiente;
+            usados = 0;
+            return;
+        }
+        
+        Bloque* nuevo = new Bloque();
+        
+        if (actual == nullptr) {
+            primero = nuevo;
+        } else {
+            actual->siguiente = nuevo;
+        }
+        
+        ultimo = nuevo;
+        actual = nuevo;
+        usados = 0;
+    }
+    
+public:
+    PoolDeNodos() : primero(nullptr), ultimo(nullptr), actual(nullptr), usados(0) {}
+    
+    PoolDeNodos(const PoolDeNodos&) = delete;
+    PoolDeNodos& operator=(const PoolDeNodos&) = delete;
+    
+    /**
+     * @brief Destructor que libera todos los bloques
+     */
+    ~PoolDeNodos() {
+        Bloque* bloque = primero;
+        while (bloque != nullptr) {
+            Bloque* siguiente = bloque->siguiente;
+            delete bloque;
+            bloque = siguiente;
+        }
+    }
+    
+    /**
+     * @brief Entrega un nodo sin enlazar con el dato indicado
+     * @param dato Carácter del nodo
+     */
+    NodoCarga* obtener(char dato) {
+        if (actual == nullptr || usados == NODOS_POR_BLOQUE) {
+            abrirBloque();
+        }
+        
+        NodoCarga* nodo = &actual->nodos[usados++];
+        nodo->dato = dato;
+        nodo->siguiente = nullptr;
+        nodo->previo = nullptr;
+        return nodo;
+    }
+    
+    /**
+     * @brief Entrega hasta 'cantidad' nodos contiguos del mismo bloque
+     * @param cantidad Nodos solicitados (mayor que 0)
+     * @param entregados Recibe cuántos nodos se entregaron (al menos 1)
+     * @return Puntero al primero de los nodos, sin inicializar sus enlaces
+     */
+    NodoCarga* reservarContiguos(int cantidad, int& entregados) {
+        if (actual == nullptr || usados == NODOS_POR_BLOQUE) {
+            abrirBloque();
+        }
+        
+        int libres = NODOS_POR_BLOQUE - usados;
+        entregados = cantidad < libres ? cantidad : libres;
+        
+        NodoCarga* inicio = &actual->nodos[usados];
+        usados += entregados;
+        return inicio;
+    }
+    
+    /**
+     * @brief Toma posesión de todos los bloques de otro pool en O(1)
+     * * Los bloques de 'otro' se encadenan después de los propios y las
+     * siguientes reservas continúan en su último bloque. 'otro' queda vacío.
+     */
+    void absorber(PoolDeNodos& otro) {
+        if (otro.primero == nullptr) return;
+        
+        // Los bloques reciclados que siguen al actual pasan al final de 'otro'
+        Bloque* sobrantes = nullptr;
+        if (actual == nullptr) {
+            primero = otro.primero;
+        } else {
+            sobrantes = actual->siguiente;
+            actual->siguiente = otro.primero;
+        }
+        
+        if (sobrantes != nullptr) {
+            otro.ultimo->siguiente = sobrantes;    // 'ultimo' sigue siendo el último sobrante
+        } else {
+            ultimo = otro.ultimo;
+        }
+        
+        actual = otro.actual;
+        usados = otro.usados;
+        
+        otro.primero = otro.ultimo = otro.actual = nullptr;
+        otro.usados = 0;
+    }
+    
+    /**
+     * @brief Da por libres todos los nodos entregados, conservando los bloques
+     * * Las siguientes reservas reutilizan los bloques desde el primero, así
+     * que la memoria queda acotada por la mayor cantidad de nodos en uso a
+     * la vez. Los nodos entregados antes ya no deben usarse.
+     */
+    void reciclar() {
+        actual = primero;
+        usados = 0;
+    }
+};
+class ListaDeCarga;
+class RotorEnlazado;
+template <typename Alfabeto> class RotorSobreAlfabeto;
+struct AlfabetoMayusculas;
+struct AlfabetoAlfanumerico;
+struct AlfabetoBytes;
+template <typename Alfabeto, int ROTORES> class CascadaDeRotores;
+
+/**
+ * @brief Rotor indexado sobre A-Z, equivalente a RotorEnlazado
+ */
+typedef RotorSobreAlfabeto<AlfabetoMayusculas> RotorIndexado;
+
+/**
+ * @brief Rotor indexado sobre A-Z, a-z y 0-9
+ */
+typedef RotorSobreAlfabeto<AlfabetoAlfanumerico> RotorAlfanumerico;
+
+/**
+ * @brief Rotor indexado sobre los 256 valores de un byte
+ */
+typedef RotorSobreAlfabeto<AlfabetoBytes> RotorDeBytes;
+
+/**
+ * @brief Motor de rotor usado por las tramas
+ * * Por defecto es el rotor indexado sobre A-Z (O(1) por operación).
+ * PRT7_ALFABETO_ALFANUMERICO y PRT7_ALFABETO_BYTES eligen los alfabetos
+ * ampliados; PRT7_ROTOR_ENLAZADO usa la lista circular doblemente enlazada
+ * (solo A-Z). Todos exponen la misma interfaz: rotar(), getMapeo() y
+ * getCabeza(). Con PRT7_ROTORES mayor que 1 se usa una cascada de ese
+ * número de rotores (ver CascadaDeRotores).
+ */
+#if defined(PRT7_ALFABETO_BYTES)
+typedef AlfabetoBytes AlfabetoDeMapeo;
+#elif defined(PRT7_ALFABETO_ALFANUMERICO)
+typedef AlfabetoAlfanumerico AlfabetoDeMapeo;
+#else
+typedef AlfabetoMayusculas AlfabetoDeMapeo;
+#endif
+
+#if defined(PRT7_ROTOR_ENLAZADO)
+typedef RotorEnlazado RotorDeMapeo;
+#elif defined(PRT7_ROTORES) && PRT7_ROTORES > 1
+typedef CascadaDeRotores<AlfabetoDeMapeo, PRT7_ROTORES> RotorDeMapeo;
+#else
+typedef RotorSobreAlfabeto<AlfabetoDeMapeo> RotorDeMapeo;
+#endif
+/**
+ * @brief Clase base abstracta para todas las tramas del protocolo PRT-7
+ */
+class TramaBase {
+public:
+    /**
+     * @brief Método virtual puro para procesar la trama
+     * @param carga Puntero a la lista de carga donde se almacenan caracteres
+     * @param rotor Puntero al rotor de mapeo circular
+     */
+    virtual void procesar(ListaDeCarga*, RotorDeMapeo* rotor) = 0;
+    
+    /**
+     * @brief Destructor virtual obligatorio para limpieza polimórfica
+     */
+    virtual ~TramaBase() {}
+};
+/**
+ * @brief Implementación del rotor de mapeo circular
+ * * Actúa como un "disco de cifrado" que contiene el alfabeto (A-Z)
+ * y puede rotar para cambiar el mapeo de caracteres.
+ */
+class RotorEnlazado {
+private:
+    NodoRotor* cabeza;
+    int tamanio;
+    
+public:
+    /**
+     * @brief Constructor que inicializa el rotor con A-Z
+     */
+    RotorEnlazado() : cabeza(nullptr), tamanio(0) {
+        // Crear lista circular con A-Z
+        const char* alfabeto = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+        NodoRotor* primero = nullptr;
+        NodoRotor* anterior = nullptr;
+        
+        for (int i = 0; alfabeto[i] != '\0'; i++) {
+            NodoRotor* nuevo = new NodoRotor(alfabeto[i]);
+            
+            if (primero == nullptr) {
+                primero = nuevo;
+                cabeza = nuevo;
+            }
+            
+            if (anterior != nullptr) {
+                anterior->siguiente = nuevo;
+                nuevo->previo = anterior;
+            }
+            
+            anterior = nuevo;
+            tamanio++;
+        }
+        
+        // Cerrar el círculo
+        if (anterior != nullptr && primero != nullptr) {
+            anterior->siguiente = primero;
+            primero->previo = anterior;
+        }
+    }
+    
+    /**
+     * @brief Destructor que libera toda la memoria del rotor
+     */
+    ~RotorEnlazado() {
+        if (cabeza == nullptr) return;
+        
+        NodoRotor* actual = cabeza;
+        NodoRotor* siguiente;
+        
+        // Romper el círculo
+        cabeza->previo->siguiente = nullptr;
+        
+        while (actual != nullptr) {
+            siguiente = actual->siguiente;
+            delete actual;
+            actual = siguiente;
+        }
+    }
+    
+    /**
+     * @brief Rota el rotor N posiciones (Versión Eficiente)
+     * @param n Número de posiciones a rotar (positivo o negativo)
+     */
+    void rotar(int n) {
+        if (cabeza == nullptr || tamanio == 0) return;
+        
+        // Normalizar n al rango del tamaño
+        int pasos = n % tamanio;
+        
+        if (pasos > 0) {
+            // Rotar hacia adelante
+            for (int i = 0; i < pasos; i++) {
+                cabeza = cabeza->siguiente;
+            }
+        } else if (pasos < 0) {
+            // Rotar hacia atrás
+            for (int i = 0; i < -pasos; i++) {
+                cabeza = cabeza->previo;
+            }
+        }
+        // Si pasos == 0, no hacer nada
+    }
+    
+    /**
+     * @brief Vuelve el rotor a su posición inicial ('A' se mapea a 'A')
+     */
+    void reiniciar() {
+        rotar(-getDesplazamiento());
+    }
+    
+    /**
+     * @brief Obtiene el mapeo de un carácter según la rotación actual
+     * @param in Carácter de entrada
+     * @return Carácter mapeado según la posición del rotor
+     */
+    char getMapeo(char in) {
+        // Si no es letra mayúscula, retornar sin cambios
+        if (in < 'A' || in > 'Z') {
+            return in;
+        }
+        
+        // 1. Calcular la posición alfabética absoluta (A=0, B=1, ...)
+        int posicion = in - 'A';
+        
+        // 2. Iniciar en la cabeza actual del rotor
+        NodoRotor* actual = cabeza;
+        
+        // 3. Avanzar 'posicion' pasos desde la cabeza
+        for (int i = 0; i < posicion; i++) {
+            actual = actual->siguiente;
+        }
+        
+        // 4. Devolver el carácter en esa nueva posición
+        return actual->dato;
+    }
+    
+    /**
+     * @brief Obtiene el carácter actual de la cabeza (posición 'A')
+     */
+    char getCabeza() const {
+        return cabeza ? cabeza->dato : 'A';
+    }
+    
+    /**
+     * @brief Obtiene cuántas posiciones está rotada la cabeza respecto a 'A'
+     */
+    int getDesplazamiento() const {
+        return cabeza ? cabeza->dato - 'A' : 0;
+    }
+    
+    /**
+     * @brief Obtiene la cantidad de símbolos del rotor
+     */
+    int getTamanio() const {
+        return tamanio;
+    }
+};
+/**
+ * @brief Alfabeto A-Z del protocolo original
+ * * Un alfabeto es un tipo con TAMANIO y una función constexpr simbolo(i)
+ * que hace de tabla en tiempo de compilación.
+ */
+struct AlfabetoMayusculas {
+    static const int TAMANIO = 26;
+    
+    static constexpr char simbolo(int i) {
+        return (char)('A' + i);
+    }
+};
+
+/**
+ * @brief Alfabeto A-Z, a-z, 0-9 (en ese orden)
+ */
+struct AlfabetoAlfanumerico {
+    static const int TAMANIO = 62;
+    
+    static constexpr char simbolo(int i) {
+        return i < 26 ? (char)('A' + i) : i < 52 ? (char)('a' + i - 26) : (char)('0' + i - 52);
+    }
+};
+
+/**
+ * @brief Alfabeto de los 256 valores de un byte
+ */
+struct AlfabetoBytes {
+    static const int TAMANIO = 256;
+    
+    static constexpr char simbolo(int i) {
+        return (char)(unsigned char)i;
+    }
+};
+
+/**
+ * @brief Rotor de mapeo sobre un alfabeto conocido en tiempo de compilación
+ * * Equivalente a RotorEnlazado, pero la cabeza es un índice dentro del
+ * alfabeto: rotar es un solo cálculo con módulo constante
+ * (Alfabeto::TAMANIO) en lugar de recorrer nodos.
+ * * Mantiene una tabla de traducción de 256 entradas que se actualiza solo
+ * cuando cambia la cabeza, y solo en las posiciones del alfabeto (los demás
+ * bytes se traducen siempre a sí mismos). Así getMapeo() es una única
+ * lectura de tabla, sin ramas.
+ */
+template <typename Alfabeto>
+class RotorSobreAlfabeto {
+private:
+    static const int TAMANIO = Alfabeto::TAMANIO;
+    static const int TAMANIO_TABLA = 256;
+    
+    static_assert(TAMANIO > 0 && TAMANIO <= TAMANIO_TABLA, "El alfabeto debe tener entre 1 y 256 simbolos");
+    
+    int cabeza;     // Posición del símbolo que ocupa el lugar del primero
+    char tabla[TAMANIO_TABLA];
+    
+    /**
+     * @brief Recalcula las posiciones del alfabeto para la cabeza actual
+     */
+    void reconstruirTabla() {
+        int destino = cabeza;
+        
+        for (int i = 0; i < TAMANIO; i++) {
+            tabla[(unsigned char)Alfabeto::simbolo(i)] = Alfabeto::simbolo(destino);
+            if (++destino == TAMANIO) destino = 0;
+        }
+    }
+    
+public:
+    /**
+     * @brief Constructor que deja el rotor en su posición inicial (identidad)
+     */
+    RotorSobreAlfabeto() : cabeza(0) {
+        for (int i = 0; i < TAMANIO_TABLA; i++) {
+            tabla[i] = (char)i;
+        }
+        reconstruirTabla();
+    }
+    
+    /**
+     * @brief Rota el rotor N posiciones en O(1) más la actualización de la tabla
+     * @param n Número de posiciones a rotar (positivo o negativo)
+     */
+    void rotar(int n) {
+        // n % TAMANIO queda en (-TAMANIO, TAMANIO); sumar TAMANIO lo deja positivo
+        int nuevaCabeza = (cabeza + n % TAMANIO + TAMANIO) % TAMANIO;
+        
+        if (nuevaCabeza != cabeza) {
+            cabeza = nuevaCabeza;
+            reconstruirTabla();
+        }
+    }
+    
+    /**
+     * @brief Vuelve el rotor a su posición inicial (identidad)
+     */
+    void reiniciar() {
+        if (cabeza != 0) {
+            cabeza = 0;
+            reconstruirTabla();
+        }
+    }
+    
+    /**
+     * @brief Obtiene el mapeo de un carácter según la rotación actual
+     * @param in Carácter de entrada
+     * @return Carácter mapeado (los bytes fuera del alfabeto, sin cambio)
+     */
+    char getMapeo(char in) const {
+        return tabla[(unsigned char)in];
+    }
+    
+    /**
+     * @brief Obtiene el símbolo que ocupa el lugar del primero (p. ej. 'A')
+     */
+    char getCabeza() const {
+        return Alfabeto::simbolo(cabeza);
+    }
+    
+    /**
+     * @brief Obtiene cuántas posiciones está rotada la cabeza
+     */
+    int getDesplazamiento() const {
+        return cabeza;
+    }
+    
+    /**
+     * @brief Obtiene la cantidad de símbolos del rotor
+     */
+    int getTamanio() const {
+        return TAMANIO;
+    }
+};
+
+/**
+ * @brief Cascada de rotores al estilo Enigma sobre un alfabeto fijo
+ * * Cada LOAD pasa por el rotor 1, luego por el 2, y así hasta el último.
+ * El rotor k lleva el símbolo de posición i al de posición
+ * cableado[k][(i + desplazamiento[k]) % TAMANIO]; con el cableado
+ * identidad (el inicial) un solo rotor equivale a RotorSobreAlfabeto.
+ * * Las permutaciones de todos los rotores se componen en una sola tabla
+ * de 256 entradas, que se recalcula solo cuando una MAP mueve algún rotor
+ * o cambia un cableado. getMapeo() cuesta una lectura de tabla sin
+ * importar la cantidad de rotores.
+ */
+template <typename Alfabeto, int ROTORES>
+class CascadaDeRotores {
+private:
+    static const int TAMANIO = Alfabeto::TAMANIO;
+    static const int TAMANIO_TABLA = 256;
+    
+    static_assert(TAMANIO > 0 && TAMANIO <= TAMANIO_TABLA, "El alfabeto debe tener entre 1 y 256 simbolos");
+    static_assert(ROTORES >= 1, "La cascada necesita al menos un rotor");
+    
+    int desplazamiento[ROTORES];
+    unsigned char cableado[ROTORES][TAMANIO];   // Posiciones dentro del alfabeto
+    char tabla[TAMANIO_TABLA];
+    
+    /**
+     * @brief Compone todos los rotores en la tabla de traducción
+     */
+    void reconstruirTabla() {
+        for (int i = 0; i < TAMANIO; i++) {
+            int posicion = i;
+            
+            for (int k = 0; k < ROTORES; k++) {
+                int entrada = posicion + desplazamiento[k];
+                if (entrada >= TAMANIO) entrada -= TAMANIO;
+                posicion = cableado[k][entrada];
+            }
+            
+            tabla[(unsigned char)Alfabeto::simbolo(i)] = Alfabeto::simbolo(posicion);
+        }
+    }
+    
+public:
+    /**
+     * @brief Constructor: todos los rotores en 0 y con cableado identidad
+     */
+    CascadaDeRotores() {
+        for (int i = 0; i < TAMANIO_TABLA; i++) {
+            tabla[i] = (char)i;
+        }
+        for (int k = 0; k < ROTORES; k++) {
+            desplazamiento[k] = 0;
+            for (int i = 0; i < TAMANIO; i++) {
+                cableado[k][i] = (unsigned char)i;
+            }
+        }
+        reconstruirTabla();
+    }
+    
+    /**
+     * @brief Rota un rotor de la cascada
+     * @param indice Rotor a rotar (0 = el primero)
+     * @param n Número de posiciones a rotar (positivo o negativo)
+     * @return false si el rotor no existe
+     */
+    bool rotar(int indice, int n) {
+        if (indice < 0 || indice >= ROTORES) return false;
+        
+        int nuevo = (desplazamiento[indice] + n % TAMANIO + TAMANIO) % TAMANIO;
+        
+        if (nuevo != desplazamiento[indice]) {
+            desplazamiento[indice] = nuevo;
+            reconstruirTabla();
+        }
+        return true;
+    }
+    
+    /**
+     * @brief Rota el primer rotor (misma interfaz que los rotores simples)
+     */
+    void rotar(int n) {
+        rotar(0, n);
+    }
+    
+    /**
+     * @brief Vuelve todos los rotores a 0; los cableados se conservan
+     */
+    void reiniciar() {
+        for (int k = 0; k < ROTORES; k++) {
+            desplazamiento[k] = 0;
+        }
+        reconstruirTabla();
+    }
+    
+    /**
+     * @brief Reemplaza el cableado de un rotor
+     * @param indice Rotor a modificar (0 = el primero)
+     * @param simbolos Los TAMANIO símbolos del alfabeto en el orden en que
+     *        salen: el i-ésimo es la salida de la posición i
+     * @return false si el rotor no existe o simbolos no es una permutación
+     */
+    bool setCableado(int indice, const char* simbolos) {
+        if (indice < 0 || indice >= ROTORES) return false;
+        
+        int posicionDe[TAMANIO_TABLA];
+        bool usado[TAMANIO_TABLA];
+        for (int i = 0; i < TAMANIO_TABLA; i++) {
+            posicionDe[i] = -1;
+            usado[i] = false;
+        }
+        for (int i = 0; i < TAMANIO; i++) {
+            posicionDe[(unsigned char)Alfabeto::simbolo(i)] = i;
+        }
+        
+        unsigned char nuevo[TAMANIO];
+        for (int i = 0; i < TAMANIO; i++) {
+            int posicion = posicionDe[(unsigned char)simbolos[i]];
+            if (posicion < 0 || usado[posicion]) return false;
+            usado[posicion] = true;
+            nuevo[i] = (unsigned char)posicion;
+        }
+        
+        for (int i = 0; i < TAMANIO; i++) {
+            cableado[indice][i] = nuevo[i];
+        }
+        reconstruirTabla();
+        return true;
+    }
+    
+    /**
+     * @brief Obtiene el mapeo de un carácter a través de toda la cascada
+     */
+    char getMapeo(char in) const {
+        return tabla[(unsigned char)in];
+    }
+    
+    /**
+     * @brief Obtiene el símbolo al que se mapea el primero del alfabeto
+     */
+    char getCabeza() const {
+        return tabla[(unsigned char)Alfabeto::simbolo(0)];
+    }
+    
+    /**
+     * @brief Obtiene cuántas posiciones está rotado el primer rotor
+     */
+    int getDesplazamiento() const {
+        return desplazamiento[0];
+    }
+    
+    /**
+     * @brief Obtiene cuántas posiciones está rotado un rotor de la cascada
+     */
+    int getDesplazamiento(int indice) const {
+        return desplazamiento[indice];
+    }
+    
+    /**
+     * @brief Obtiene la cantidad de símbolos de cada rotor
+     */
+    int getTamanio() const {
+        return TAMANIO;
+    }
+};
+
+/**
+ * @brief Cantidad de rotores que maneja un motor de rotor
+ * * Los rotores simples tienen uno; las cascadas, los de su parámetro.
+ */
+template <typename Rotor>
+struct RotoresDe {
+    static const int CANTIDAD = 1;
+};
+
+template <typename Alfabeto, int ROTORES>
+struct RotoresDe<CascadaDeRotores<Alfabeto, ROTORES> > {
+    static const int CANTIDAD = ROTORES;
+};
+
+/**
+ * @brief Rota el rotor al que va dirigida una trama MAP
+ * * Un rotor simple solo tiene el rotor 0; las MAP dirigidas a otro se
+ * ignoran.
+ * @param rotor Motor de rotor
+ * @param indice Rotor destino (0 = el primero)
+ * @param n Posiciones a rotar
+ */
+template <typename Rotor>
+inline void rotarRotor(Rotor& rotor, int indice, int n) {
+    if (indice == 0) {
+        rotor.rotar(n);
+    }
+}
+
+template <typename Alfabeto, int ROTORES>
+inline void rotarRotor(CascadaDeRotores<Alfabeto, ROTORES>& rotor, int indice, int n) {
+    rotor.rotar(indice, n);
+}
+
+/**
+ * @brief Desplazamiento de uno de los rotores de un motor
+ * * Un rotor simple solo tiene el rotor 0; para los demás devuelve 0.
+ * @param rotor Motor de rotor
+ * @param indice Rotor consultado (0 = el primero)
+ */
+template <typename Rotor>
+inline int desplazamientoDeRotor(const Rotor& rotor, int indice) {
+    return indice == 0 ? rotor.getDesplazamiento() : 0;
+}
+
+template <typename Alfabeto, int ROTORES>
+inline int desplazamientoDeRotor(const CascadaDeRotores<Alfabeto, ROTORES>& rotor, int indice) {
+    return rotor.getDesplazamiento(indice);
+}
+
+/**
+ * @brief Modos de impresión de la lista después de cada inserción
+ */
+enum ModoImpresion {
+    IMPRESION_COMPLETA,     ///< Reimprime todos los fragmentos en cada trama
+    IMPRESION_INCREMENTAL,  ///< Imprime solo el fragmento recién agregado
+    IMPRESION_SILENCIOSA    ///< No imprime nada por trama
+};
+
+/**
+ * @brief Lista doblemente enlazada para almacenar caracteres decodificados
+ */
+class ListaDeCarga {
+private:
+    PoolDeNodos pool;
+    NodoCarga* cabeza;
+    NodoCarga* cola;
+    int tamanio;
+    ModoImpresion modo;
+    
+public:
+    /**
+     * @brief Constructor que inicializa una lista vacía
+     * @param m Modo de impresión tras cada inserción
+     */
+    ListaDeCarga(ModoImpresion m = IMPRESION_COMPLETA)
+        : cabeza(nullptr), cola(nullptr), tamanio(0), modo(m) {}
+    
+    /**
+     * @brief Destructor; los nodos se liberan por bloques junto con el pool
+     */
+    ~ListaDeCarga() {}
+    
+    /**
+     * @brief Inserta un carácter al final de la lista
+     * @param dato Carácter a insertar
+     */
+    void insertarAlFinal(char dato) {
+        NodoCarga* nuevo = pool.obtener(dato);
+        
+        if (cabeza == nullptr) {
+            cabeza = cola = nuevo;
+        } else {
+            cola->siguiente = nuevo;
+            nuevo->previo = cola;
+            cola = nuevo;
+        }
+        
+        tamanio++;
+    }
+    
+    /**
+     * @brief Inserta una secuencia de caracteres al final de la lista
+     * * Toma los nodos del pool en tramos contiguos y los enlaza en un solo
+     * recorrido, sin pasar por insertarAlFinal() carácter por carácter.
+     * @param datos Caracteres a insertar, en orden
+     * @param cantidad Número de caracteres
+     */
+    void insertarBloque(const char* datos, int cantidad) {
+        while (cantidad > 0) {
+            int entregados = 0;
+            NodoCarga* nodos = pool.reservarContiguos(cantidad, entregados);
+            
+            for (int i = 0; i < entregados; i++) {
+                nodos[i].dato = datos[i];
+                nodos[i].previo = (i > 0) ? &nodos[i - 1] : cola;
+                nodos[i].siguiente = (i + 1 < entregados) ? &nodos[i + 1] : nullptr;
+            }
+            
+            if (cabeza == nullptr) {
+                cabeza = nodos;
+            } else {
+                cola->siguiente = nodos;
+            }
+            cola = &nodos[entregados - 1];
+            
+            tamanio += entregados;
+            datos += entregados;
+            cantidad -= entregados;
+        }
+    }
+    
+    /**
+     * @brief Mueve todos los fragmentos de otra lista al final de esta
+     * * Enlaza las dos listas y transfiere los bloques del pool en O(1), sin
+     * copiar nodos. 'otra' queda vacía.
+     */
+    void concatenar(ListaDeCarga& otra) {
+        if (otra.cabeza == nullptr) return;
+        
+        if (cabeza == nullptr) {
+            cabeza = otra.cabeza;
+        } else {
+            cola->siguiente = otra.cabeza;
+            otra.cabeza->previo = cola;
+        }
+        cola = otra.cola;
+        tamanio += otra.tamanio;
+        pool.absorber(otra.pool);
+        
+        otra.cabeza = otra.cola = nullptr;
+        otra.tamanio = 0;
+    }
+    
+    /**
+     * @brief Descarta todos los fragmentos y devuelve sus nodos al pool
+     * * Los bloques ya reservados se reutilizan en las siguientes inserciones,
+     * sin liberar ni pedir memoria.
+     */
+    void vaciar() {
+        cabeza = cola = nullptr;
+        tamanio = 0;
+        pool.reciclar();
+    }
+    
+    /**
+     * @brief Obtiene la cantidad de fragmentos almacenados
+     */
+    int getTamanio() const {
+        return tamanio;
+    }
+    
+    /**
+     * @brief Obtiene el modo de impresión configurado
+     */
+    ModoImpresion getModoImpresion() const {
+        return modo;
+    }
+    
+    /**
+     * @brief Cambia el modo de impresión
+     */
+    void setModoImpresion(ModoImpresion m) {
+        modo = m;
+    }
+    
+    /**
+     * @brief Copia el mensaje a un buffer contiguo
+     * @param destino Buffer de salida (no se agrega '\0')
+     * @param capacidad Bytes disponibles en destino
+     * @return Cantidad de caracteres copiados (a lo sumo capacidad)
+     */
+    int copiarEn(char* destino, int capacidad) const {
+        int copiados = 0;
+        NodoCarga* actual = cabeza;
+        
+        while (actual != nullptr && copiados < capacidad) {
+            destino[copiados++] = actual->dato;
+            actual = actual->siguiente;
+        }
+        return copiados;
+    }
+    
+    /**
+     * @brief Copia los últimos caracteres del mensaje a un buffer contiguo
+     * * Recorre la lista desde la cola: cuesta O(cantidad), no O(tamaño).
+     * @param destino Buffer de al menos cantidad bytes (no se agrega '\0')
+     * @param cantidad Caracteres a copiar; se limita a getTamanio()
+     * @return Cantidad de caracteres copiados
+     */
+    int copiarUltimosEn(char* destino, int cantidad) const {
+        if (cantidad > tamanio) cantidad = tamanio;
+        if (cantidad <= 0) return 0;
+        
+        NodoCarga* actual = cola;
+        for (int i = 1; i < cantidad; i++) {
+            actual = actual->previo;
+        }
+        
+        for (int i = 0; i < cantidad; i++) {
+            destino[i] = actual->dato;
+            actual = actual->siguiente;
+        }
+        return cantidad;
+    }
+    
+    /**
+     * @brief Devuelve el mensaje como cadena, reservando su tamaño de una vez
+     */
+    std::string aCadena() const {
+        std::string mensaje;
+        mensaje.resize((size_t)tamanio);
+        if (tamanio > 0) {
+            copiarEn(&mensaje[0], tamanio);
+        }
+        return mensaje;
+    }
+    
+    /**
+     * @brief Escribe el mensaje en un archivo con un único fwrite()
+     * @return true si se escribieron todos los caracteres
+     */
+    bool escribirEn(std::FILE* salida) const {
+        if (tamanio == 0) return true;
+        
+        char* buffer = new char[tamanio];
+        int copiados = copiarEn(buffer, tamanio);
+        bool correcto = std::fwrite(buffer, 1, (size_t)copiados, salida) == (size_t)copiados;
+        delete[] buffer;
+        
+        return correcto;
+    }
+    
+    /**
+     * @brief Escribe el mensaje en un flujo con un único write()
+     * @return true si el flujo quedó sin errores
+     */
+    bool escribirEn(std::ostream& salida) const {
+        if (tamanio == 0) return (bool)salida;
+        
+        char* buffer = new char[tamanio];
+        int copiados = copiarEn(buffer, tamanio);
+        salida.write(buffer, copiados);
+        delete[] buffer;
+        
+        return (bool)salida;
+    }
+    
+    /**
+     * @brief Imprime el mensaje completo almacenado
+     */
+    void imprimirMensaje() const {
+        escribirEn(std::cout);
+    }
+    
+    /**
+     * @brief Imprime el mensaje con formato de fragmentos
+     */
+    void imprimirConFormato() const {
+        std::cout << "Mensaje: ";
+        NodoCarga* actual = cabeza;
+        while (actual != nullptr) {
+            std::cout << "[" << actual->dato << "]";
+            actual = actual->siguiente;
+        }
+    }
+    
+    /**
+     * @brief Imprime solo el último fragmento agregado, en O(1)
+     */
+    void imprimirUltimo() const {
+        std::cout << "Mensaje: +";
+        if (cola != nullptr) {
+            std::cout << "[" << cola->dato << "]";
+        }
+        std::cout << " (" << tamanio << " fragmentos)";
+    }
+    
+    /**
+     * @brief Imprime el avance tras una inserción según el modo configurado
+     */
+    void imprimirAvance() const {
+        if (modo == IMPRESION_COMPLETA) {
+            imprimirConFormato();
+        } else if (modo == IMPRESION_INCREMENTAL) {
+            imprimirUltimo();
+        }
+    }
+};
+
+/**
+ * @brief Destino de los mensajes ensamblados en el modo continuo
+ * * Recibe cada mensaje ya copiado a un buffer contiguo (ver
+ * ListaDeCarga::copiarEn()), terminado el ciclo por su trama FIN.
+ */
+class SumideroMensajes {
+public:
+    virtual ~SumideroMensajes() {}
+    
+    /**
+     * @brief Entrega un mensaje completo
+     * @param mensaje Caracteres del mensaje (sin '\0')
+     * @param longitud Cantidad de caracteres
+     * @param origen Prefijo que identifica la fuente (p. ej. "[COM3] "), o ""
+     * @return false si no se pudo entregar
+     */
+    virtual bool entregar(const char* mensaje, int longitud, const char* origen) = 0;
+};
+
+/**
+ * @brief Sumidero que escribe un mensaje por línea en un archivo
+ */
+class SumideroArchivo : public SumideroMensajes {
+private:
+    std::FILE* archivo;
+    bool propio;    // Si se cierra en el destructor
+    
+public:
+    /**
+     * @param a Archivo abierto para escritura
+     * @param cerrarAlFinal true para que el sumidero lo cierre al destruirse
+     */
+    SumideroArchivo(std::FILE* a, bool cerrarAlFinal) : archivo(a), propio(cerrarAlFinal) {}
+    
+    SumideroArchivo(const SumideroArchivo&) = delete;
+    SumideroArchivo& operator=(const SumideroArchivo&) = delete;
+    
+    ~SumideroArchivo() override {
+        if (propio) std::fclose(archivo);
+    }
+    
+    bool entregar(const char* mensaje, int longitud, const char* origen) override {
+        std::fputs(origen, archivo);
+        std::fwrite(mensaje, 1, (size_t)longitud, archivo);
+        std::fputc('\n', archivo);
+        return std::fflush(archivo) == 0 && !std::ferror(archivo);
+    }
+};
+
+/**
+ * @brief Sumidero que pasa cada mensaje a una función del llamador
+ */
+class SumideroFuncion : public SumideroMensajes {
+public:
+    typedef bool (*Funcion)(const char* mensaje, int longitud, const char* origen, void* contexto);
+    
+private:
+    Funcion funcion;
+    void* contexto;
+    
+public:
+    SumideroFuncion(Funcion f, void* c = nullptr) : funcion(f), contexto(c) {}
+    
+    bool entregar(const char* mensaje, int longitud, const char* origen) override {
+        return funcion(mensaje, longitud, origen, contexto);
+    }
+};
+
+/**
+ * @brief Formato binario de los puntos de control (little-endian)
+ * * | Bytes | Campo                                          |
+ * |-------|------------------------------------------------|
+ * | 4     | Firma "P7CK"                                   |
+ * | 2     | Versión (VERSION_PUNTO_DE_CONTROL)             |
+ * | 2     | Banderas (bit 0: flujo en modo binario)        |
+ * | 8     | Secuencia: tramas LOAD/MAP aplicadas           |
+ * | 4     | Símbolos del alfabeto del rotor                |
+ * | 4     | Cantidad de rotores (R)                        |
+ * | 4     | Longitud del mensaje (L)                       |
+ * | 4 × R | Desplazamiento de cada rotor                   |
+ * | L     | Mensaje ensamblado hasta el momento            |
+ *
+ * Detrás de esa imagen pueden venir registros incrementales, cada uno con
+ * los caracteres agregados desde el anterior y el estado completo del
+ * rotor y del flujo (el último registro manda):
+ *
+ * | Bytes | Campo                                          |
+ * |-------|------------------------------------------------|
+ * | 4     | Firma "P7DL"                                   |
+ * | 2     | Reservado (0)                                  |
+ * | 2     | Banderas (como en la imagen)                   |
+ * | 8     | Secuencia                                      |
+ * | 4     | Caracteres nuevos (N)                          |
+ * | 4 × R | Desplazamiento de cada rotor                   |
+ * | N     | Caracteres agregados al mensaje                |
+ */
+const char FIRMA_PUNTO_DE_CONTROL[4] = {'P', '7', 'C', 'K'};
+const char FIRMA_REGISTRO_PC[4] = {'P', '7', 'D', 'L'};
+const int VERSION_PUNTO_DE_CONTROL = 1;
+const int ENCABEZADO_PUNTO_DE_CONTROL = 28;
+const int ENCABEZADO_REGISTRO_PC = 20;
+const int BANDERA_PC_BINARIO = 0x0001;
+
+/**
+ * @brief Lo que un punto de control guarda además del rotor y el mensaje
+ */
+struct EstadoDeFlujo {
+    unsigned long long secuencia;   ///< Tramas LOAD/MAP aplicadas desde el primer arranque
+    bool binario;                   ///< El emisor ya anunció MODO BINARIO
+    
+    EstadoDeFlujo() : secuencia(0), binario(false) {}
+};
+
+inline void escribirU16(char* p, unsigned int valor) {
+    p[0] = (char)(valor & 0xFF);
+    p[1] = (char)((valor >> 8) & 0xFF);
+}
+
+inline void escribirU32(char* p, unsigned long valor) {
+    for (int i = 0; i < 4; i++) {
+        p[i] = (char)((valor >> (8 * i)) & 0xFF);
+    }
+}
+
+inline void escribirU64(char* p, unsigned long long valor) {
+    for (int i = 0; i < 8; i++) {
+        p[i] = (char)((valor >> (8 * i)) & 0xFF);
+    }
+}
+
+inline unsigned int leerU16(const char* p) {
+    return (unsigned int)(unsigned char)p[0] | ((unsigned int)(unsigned char)p[1] << 8);
+}
+
+inline unsigned long leerU32(const char* p) {
+    unsigned long valor = 0;
+    for (int i = 3; i >= 0; i--) {
+        valor = (valor << 8) | (unsigned char)p[i];
+    }
+    return valor;
+}
+
+inline unsigned long long leerU64(const char* p) {
+    unsigned long long valor = 0;
+    for (int i = 7; i >= 0; i--) {
+        valor = (valor << 8) | (unsigned char)p[i];
+    }
+    return valor;
+}
+
+/**
+ * @brief Bytes que ocupa el punto de control de un motor y un mensaje
+ */
+template <typename Rotor>
+inline int tamanioPuntoDeControl(const ListaDeCarga& carga) {
+    return ENCABEZADO_PUNTO_DE_CONTROL + 4 * RotoresDe<Rotor>::CANTIDAD + carga.getTamanio();
+}
+
+/**
+ * @brief Serializa rotor, mensaje y estado del flujo en un buffer
+ * @param destino Buffer de al menos tamanioPuntoDeControl<Rotor>(carga) bytes
+ * @param capacidad Tamaño del buffer
+ * @return Bytes escritos, o -1 si no caben
+ */
+template <typename Rotor>
+inline int serializarPuntoDeControl(const ListaDeCarga& carga, const Rotor& rotor,
+                                    const EstadoDeFlujo& estado, char* destino, int capacidad) {
+    const int ROTORES = RotoresDe<Rotor>::CANTIDAD;
+    int total = tamanioPuntoDeControl<Rotor>(carga);
+    if (total > capacidad) return -1;
+    
+    std::memcpy(destino, FIRMA_PUNTO_DE_CONTROL, 4);
+    escribirU16(destino + 4, VERSION_PUNTO_DE_CONTROL);
+    escribirU16(destino + 6, estado.binario ? BANDERA_PC_BINARIO : 0);
+    escribirU64(destino + 8, estado.secuencia);
+    escribirU32(destino + 16, (unsigned long)rotor.getTamanio());
+    escribirU32(destino + 20, (unsigned long)ROTORES);
+    escribirU32(destino + 24, (unsigned long)carga.getTamanio());
+    
+    char* p = destino + ENCABEZADO_PUNTO_DE_CONTROL;
+    for (int k = 0; k < ROTORES; k++) {
+        escribirU32(p, (unsigned long)desplazamientoDeRotor(rotor, k));
+        p += 4;
+    }
+    carga.copiarEn(p, carga.getTamanio());
+    
+    return total;
+}
+
+/**
+ * @brief Bytes que ocupa un registro incremental con 'nuevos' caracteres
+ */
+template <typename Rotor>
+inline int tamanioRegistroPuntoDeControl(int nuevos) {
+    return ENCABEZADO_REGISTRO_PC + 4 * RotoresDe<Rotor>::CANTIDAD + nuevos;
+}
+
+/**
+ * @brief Serializa un registro incremental: los últimos 'nuevos' caracteres
+ *        del mensaje más el estado actual de rotor y flujo
+ * * Cuesta O(nuevos): no recorre el mensaje completo (ver
+ * ListaDeCarga::copiarUltimosEn()).
+ * @param destino Buffer de al menos tamanioRegistroPuntoDeControl<Rotor>(nuevos) bytes
+ * @return Bytes escritos, o -1 si no caben o 'nuevos' excede el mensaje
+ */
+template <typename Rotor>
+inline int serializarRegistroPuntoDeControl(const ListaDeCarga& carga, int nuevos, const Rotor& rotor,
+                                            const EstadoDeFlujo& estado, char* destino, int capacidad) {
+    const int ROTORES = RotoresDe<Rotor>::CANTIDAD;
+    if (nuevos < 0 || nuevos > carga.getTamanio()) return -1;
+    int total = tamanioRegistroPuntoDeControl<Rotor>(nuevos);
+    if (total > capacidad) return -1;
+    
+    std::memcpy(destino, FIRMA_REGISTRO_PC, 4);
+    escribirU16(destino + 4, 0);
+    escribirU16(destino + 6, estado.binario ? BANDERA_PC_BINARIO : 0);
+    escribirU64(destino + 8, estado.secuencia);
+    escribirU32(destino + 16, (unsigned long)nuevos);
+    
+    char* p = destino + ENCABEZADO_REGISTRO_PC;
+    for (int k = 0; k < ROTORES; k++) {
+        escribirU32(p, (unsigned long)desplazamientoDeRotor(rotor, k));
+        p += 4;
+    }
+    carga.copiarUltimosEn(p, nuevos);
+    
+    return total;
+}
+
+/**
+ * @brief Restaura rotor, mensaje y estado del flujo desde un punto de control
+ * * Solo acepta puntos de control del mismo motor (alfabeto y cantidad de
+ * rotores); si no, no toca nada. Aplica los registros incrementales que
+ * sigan a la imagen. Un registro incompleto al final (el proceso murió a
+ * mitad de la escritura) se ignora; uno con firma o desplazamientos
+ * inválidos invalida el archivo completo.
+ * @param datos Contenido completo del punto de control
+ * @param longitud Bytes en datos
+ * @return false si el punto de control no es válido para este motor
+ */
+template <typename Rotor>
+inline bool restaurarPuntoDeControl(const char* datos, int longitud, ListaDeCarga& carga, Rotor& rotor,
+                                    EstadoDeFlujo& estado) {
+    const int ROTORES = RotoresDe<Rotor>::CANTIDAD;
+    const int base = ENCABEZADO_PUNTO_DE_CONTROL + 4 * ROTORES;
+    const int encabezadoRegistro = ENCABEZADO_REGISTRO_PC + 4 * ROTORES;
+    if (longitud < base) return false;
+    if (std::memcmp(datos, FIRMA_PUNTO_DE_CONTROL, 4) != 0) return false;
+    if (leerU16(datos + 4) != (unsigned int)VERSION_PUNTO_DE_CONTROL) return false;
+    
+    unsigned long simbolos = leerU32(datos + 16);
+    unsigned long largoMensaje = leerU32(datos + 24);
+    if (simbolos != (unsigned long)rotor.getTamanio()) return false;
+    if (leerU32(datos + 20) != (unsigned long)ROTORES) return false;
+    // En 64 bits: con unsigned long de 32 bits (Windows) la resta podría dar la vuelta
+    if ((long long)largoMensaje > (long long)longitud - base) return false;
+    
+    for (int k = 0; k < ROTORES; k++) {
+        if (leerU32(datos + ENCABEZADO_PUNTO_DE_CONTROL + 4 * k) >= simbolos) return false;
+    }
+    
+    // Primera pasada: validar los registros sin tocar carga ni rotor
+    const char* ultimo = datos;                                     // Dueño de banderas y secuencia
+    const char* desplazamientos = datos + ENCABEZADO_PUNTO_DE_CONTROL;
+    int fin = base + (int)largoMensaje;
+    
+    while (longitud - fin >= encabezadoRegistro) {
+        const char* registro = datos + fin;
+        long long nuevos = (long long)leerU32(registro + 16);
+        if (nuevos > (long long)(longitud - fin - encabezadoRegistro)) break;   // Registro incompleto
+        
+        if (std::memcmp(registro, FIRMA_REGISTRO_PC, 4) != 0) return false;
+        for (int k = 0; k < ROTORES; k++) {
+            if (leerU32(registro + ENCABEZADO_REGISTRO_PC + 4 * k) >= simbolos) return false;
+        }
+        
+        ultimo = registro;
+        desplazamientos = registro + ENCABEZADO_REGISTRO_PC;
+        fin += encabezadoRegistro + (int)nuevos;
+    }
+    
+    // Segunda pasada: aplicar
+    rotor.reiniciar();
+    for (int k = 0; k < ROTORES; k++) {
+        rotarRotor(rotor, k, (int)leerU32(desplazamientos + 4 * k));
+    }
+    
+    carga.vaciar();
+    carga.insertarBloque(datos + base, (int)largoMensaje);
+    for (int posicion = base + (int)largoMensaje; posicion < fin; ) {
+        int nuevos = (int)leerU32(datos + posicion + 16);
+        carga.insertarBloque(datos + posicion + encabezadoRegistro, nuevos);
+        posicion += encabezadoRegistro + nuevos;
+    }
+    
+    estado.secuencia = leerU64(ultimo + 8);
+    estado.binario = (leerU16(ultimo + 6) & BANDERA_PC_BINARIO) != 0;
+    return true;
+}
+
+/**
+ * @brief Trama de tipo LOAD - Contiene un carácter para decodificar
+ */
+class TramaLoad : public TramaBase {
+private:
+    char caracter;
+    
+public:
+    TramaLoad(char c) : caracter(c) {}
+    
+    void procesar(ListaDeCarga* carga, RotorDeMapeo* rotor) override {
+        aplicar(caracter, carga, rotor);
+    }
+    
+    /**
+     * @brief Decodifica e inserta un carácter sin necesitar una instancia
+     * @param caracter Carácter recibido en la trama
+     * @param carga Lista donde se inserta el carácter decodificado
+     * @param rotor Rotor que define el mapeo actual
+     */
+    static void aplicar(char caracter, ListaDeCarga* carga, RotorDeMapeo* rotor) {
+        char decodificado = rotor->getMapeo(caracter);
+        carga->insertarAlFinal(decodificado);
+        informar(caracter, decodificado, carga);
+    }
+    
+    /**
+     * @brief Imprime el avance de un carácter ya decodificado e insertado
+     */
+    static void informar(char caracter, char decodificado, const ListaDeCarga* carga) {
+        if (carga->getModoImpresion() == IMPRESION_SILENCIOSA) return;
+        
+        // Manejo especial para el espacio en la impresión
+        char c_print = (caracter == ' ') ? ' ' : caracter;
+        char d_print = (decodificado == ' ') ? ' ' : decodificado;
+        
+        std::cout << "Fragmento '" << c_print << "' decodificado como '" 
+                  << d_print << "'. ";
+        carga->imprimirAvance();
+        std::cout << '\n';
+    }
+};
+
+/**
+ * @brief Trama de tipo MAP - Contiene instrucción de rotación
+ */
+class TramaMap : public TramaBase {
+private:
+    int rotacion;
+    int destino;
+    
+public:
+    TramaMap(int n, int d = 0) : rotacion(n), destino(d) {}
+    
+    void procesar(ListaDeCarga* carga, RotorDeMapeo* rotor) override {
+        aplicar(rotacion, carga, rotor, destino);
+    }
+    
+    /**
+     * @brief Aplica una rotación sin necesitar una instancia
+     * @param rotacion Posiciones a rotar (positivo o negativo)
+     * @param carga Lista de carga (solo se consulta su modo de impresión)
+     * @param rotor Rotor a rotar
+     * @param destino Rotor de la cascada al que va dirigida (0 = el primero)
+     */
+    static void aplicar(int rotacion, ListaDeCarga* carga, RotorDeMapeo* rotor, int destino = 0) {
+        rotarRotor(*rotor, destino, rotacion);
+        informar(rotacion, carga, rotor, destino);
+    }
+    
+    /**
+     * @brief Imprime una rotación ya aplicada al rotor
+     */
+    static void informar(int rotacion, const ListaDeCarga* carga, const RotorDeMapeo* rotor,
+                         int destino = 0) {
+        if (carga->getModoImpresion() == IMPRESION_SILENCIOSA) return;
+        
+        std::cout << "ROTANDO ROTOR ";
+        if (destino != 0) {
+            std::cout << (destino + 1) << ' ';
+        }
+        std::cout << (rotacion >= 0 ? "+" : "") << rotacion 
+                  << ". (Ahora 'A' se mapea a '" << rotor->getCabeza() << "')" 
+                  << '\n';
+    }
+};
+/**
+ * @brief Compara dos cadenas manualmente
+ */
+inline bool sonIguales(const char* str1, const char* str2) {
+    int i = 0;
+    while (str1[i] != '\0' && str2[i] != '\0') {
+        if (str1[i] != str2[i]) return false;
+        i++;
+    }
+    return str1[i] == str2[i];
+}
+
+/**
+ * @brief Convierte cadena a entero manualmente
+ * @param str Inicio de los dígitos (con signo opcional)
+ * @param longitud Bytes disponibles a partir de str
+ */
+inline int aEntero(const char* str, int longitud) {
+    int resultado = 0;
+    int signo = 1;
+    int i = 0;
+    
+    if (longitud > 0 && str[0] == '-') {
+        signo = -1;
+        i = 1;
+    } else if (longitud > 0 && str[0] == '+') {
+        i = 1;
+    }
+    
+    while (i < longitud && str[i] >= '0' && str[i] <= '9') {
+        resultado = resultado * 10 + (str[i] - '0');
+        i++;
+    }
+    
+    return resultado * signo;
+}
+
+/**
+ * @brief Tipos de trama reconocidos por el analizador
+ */
+enum TipoTrama {
+    TRAMA_INVALIDA,
+    TRAMA_LOAD,
+    TRAMA_MAP,
+    TRAMA_FIN,          ///< Fin de transmisión ("FIN" o el código binario)
+    TRAMA_SALUDO,       ///< Línea de control "SISTEMA PRT-7 ACTIVO"
+    TRAMA_MODO_BINARIO  ///< Línea de control que activa el formato binario
+};
+
+/**
+ * @brief Líneas de control del formato de texto
+ */
+const char TEXTO_FIN[] = "FIN";
+const char TEXTO_SALUDO[] = "SISTEMA PRT-7 ACTIVO";
+const char TEXTO_MODO_BINARIO[] = "MODO BINARIO";
+
+/**
+ * @brief Representación por valor de una trama ya analizada
+ * * Permite al bucle de decodificación procesar cada trama sin reservar
+ * memoria dinámica. La jerarquía TramaBase sigue disponible mediante
+ * parsearTrama() para quien necesite extenderla.
+ */
+struct Trama {
+    TipoTrama tipo;
+    char caracter;  ///< Carácter de una trama LOAD
+    int rotacion;   ///< Rotación de una trama MAP
+    int destino;    ///< Rotor al que va dirigida una trama MAP (0 = el primero)
+    
+    Trama() : tipo(TRAMA_INVALIDA), caracter('\0'), rotacion(0), destino(0) {}
+};
+
+/**
+ * @brief Lee un entero decimal con signo opcional en una sola pasada
+ * @param p Primer byte del número
+ * @param fin Fin de la línea
+ * @param valor Recibe el número (0 si no hay dígitos)
+ * @return Puntero al primer byte que no forma parte del número
+ */
+inline const char* leerEntero(const char* p, const char* fin, int& valor) {
+    int signo = 1;
+    
+    if (p < fin && (*p == '-' || *p == '+')) {
+        if (*p == '-') signo = -1;
+        p++;
+    }
+    
+    int resultado = 0;
+    while (p < fin && (unsigned)(*p - '0') < 10u) {
+        resultado = resultado * 10 + (*p - '0');
+        p++;
+    }
+    
+    valor = resultado * signo;
+    return p;
+}
+
+/**
+ * @brief Compara una línea completa con una línea de control conocida
+ */
+template <int N>
+inline bool esLineaDeControl(const char* linea, int longitud, const char (&texto)[N]) {
+    return longitud == N - 1 && std::memcmp(linea, texto, (size_t)(N - 1)) == 0;
+}
+
+/**
+ * @brief Clasifica y analiza una línea de texto en una sola pasada
+ * * Trabaja directamente sobre la vista de la línea dentro del buffer de
+ * lectura, sin copiarla ni necesitar '\0'. El primer byte decide el tipo
+ * con un switch (una tabla de saltos): 'L' y 'M' seguidos de ',' son
+ * tramas, 'F' y 'S' solo pueden ser FIN o el saludo, y 'M' sin coma solo
+ * puede ser "MODO BINARIO". Los números se leen una única vez, de izquierda
+ * a derecha.
+ * @param linea Inicio de la línea (sin '\r' ni '\n')
+ * @param longitud Cantidad de bytes de la línea
+ * @param trama Recibe los datos de una trama LOAD o MAP
+ * @return Tipo de la línea (TRAMA_INVALIDA si está mal formada)
+ */
+inline TipoTrama clasificarLinea(const char* linea, int longitud, Trama& trama) {
+    // Formato: "L,X", "M,N" o "M,N,K" (MAP al rotor K de la cascada, desde 1)
+    trama.tipo = TRAMA_INVALIDA;
+    
+    if (longitud < 1) return TRAMA_INVALIDA;
+    
+    const char* fin = linea + longitud;
+    TipoTrama tipo = TRAMA_INVALIDA;
+    
+    switch (linea[0]) {
+        case 'L':
+            if (longitud >= 3 && linea[1] == ',') {
+                trama.caracter = linea[2];
+                // Manejo especial para 'Space' del README
+                if (longitud >= 5 && linea[2] == 'S' && linea[3] == 'p' && linea[4] == 'a') {
+                    trama.caracter = ' ';
+                }
+                tipo = TRAMA_LOAD;
+            }
+            break;
+            
+        case 'M':
+            if (longitud >= 2 && linea[1] == ',') {
+                const char* p = leerEntero(linea + 2, fin, trama.rotacion);
+                trama.destino = 0;
+                
+                if (p < fin && *p == ',') {
+                    int rotorDestino;
+                    leerEntero(p + 1, fin, rotorDestino);
+                    if (rotorDestino < 1) break;
+                    trama.destino = rotorDestino - 1;
+                }
+                tipo = TRAMA_MAP;
+            } else if (esLineaDeControl(linea, longitud, TEXTO_MODO_BINARIO)) {
+                tipo = TRAMA_MODO_BINARIO;
+            }
+            break;
+            
+        case 'F':
+            if (esLineaDeControl(linea, longitud, TEXTO_FIN)) {
+                tipo = TRAMA_FIN;
+            }
+            break;
+            
+        case 'S':
+            if (esLineaDeControl(linea, longitud, TEXTO_SALUDO)) {
+                tipo = TRAMA_SALUDO;
+            }
+            break;
+            
+        default:
+            break;
+    }
+    
+    trama.tipo = tipo;
+    return tipo;
+}
+
+/**
+ * @brief Analiza una línea del serial sin crear objetos en el heap
+ * @param linea Inicio de la línea (no necesita terminar en '\0')
+ * @param longitud Cantidad de bytes de la línea
+ * @param trama Recibe el tipo y los datos de la trama
+ * @return true si es una trama LOAD o MAP válida
+ */
+inline bool analizarTrama(const char* linea, int longitud, Trama& trama) {
+    TipoTrama tipo = clasificarLinea(linea, longitud, trama);
+    return tipo == TRAMA_LOAD || tipo == TRAMA_MAP;
+}
+
+/**
+ * @brief Procesa una trama por valor, sin despacho virtual ni heap
+ */
+inline void procesarTrama(const Trama& trama, ListaDeCarga* carga, RotorDeMapeo* rotor) {
+    switch (trama.tipo) {
+        case TRAMA_LOAD:
+            TramaLoad::aplicar(trama.caracter, carga, rotor);
+            break;
+        case TRAMA_MAP:
+            TramaMap::aplicar(trama.rotacion, carga, rotor, trama.destino);
+            break;
+        case TRAMA_INVALIDA:
+        case TRAMA_FIN:
+        case TRAMA_SALUDO:
+        case TRAMA_MODO_BINARIO:
+            break;
+    }
+}
+
+/**
+ * @brief Compara una línea (sin '\0') con una cadena terminada en '\0'
+ */
+inline bool coincideLinea(const char* linea, int longitud, const char* texto) {
+    int i = 0;
+    while (i < longitud && texto[i] != '\0') {
+        if (linea[i] != texto[i]) return false;
+        i++;
+    }
+    return i == longitud && texto[i] == '\0';
+}
+
+/**
+ * @brief Códigos de operación del formato binario de PRT-7
+ * * El emisor lo activa enviando la línea de control "MODO BINARIO"; desde
+ * ahí cada trama empieza con un byte de código y ya no hay fin de línea:
+ * - LOAD: código + 1 byte con el carácter (2 bytes contra 5 de "L,X\r\n").
+ * - MAP: código + rotación en varint zigzag (1 byte si |n| < 64).
+ * - FIN: solo el código.
+ * Con el bit BINARIO_CON_CRC encendido, la trama termina con un CRC-8
+ * (polinomio 0x07) de los bytes anteriores.
+ */
+enum CodigoBinario {
+    BINARIO_LOAD = 0x01,
+    BINARIO_MAP = 0x02,
+    BINARIO_FIN = 0x03,
+    BINARIO_CON_CRC = 0x80
+};
+
+/**
+ * @brief Longitud máxima de una trama binaria: código, varint de 32 bits y CRC
+ */
+const int MAX_TRAMA_BINARIA = 7;
+
+/**
+ * @brief CRC-8 con polinomio 0x07 y valor inicial 0
+ */
+inline unsigned char crc8(const char* datos, int longitud) {
+    unsigned char crc = 0;
+    
+    for (int i = 0; i < longitud; i++) {
+        crc ^= (unsigned char)datos[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80) ? (unsigned char)((crc << 1) ^ 0x07) : (unsigned char)(crc << 1);
+        }
+    }
+    
+    return crc;
+}
+
+/**
+ * @brief Mide la trama binaria que empieza en datos, sin consumirla
+ * @param disponibles Bytes ya recibidos a partir de datos
+ * @return Longitud de la trama, 0 si aún faltan bytes o -1 si el código
+ *         (o el varint) es inválido
+ */
+inline int medirTramaBinaria(const char* datos, int disponibles) {
+    if (disponibles < 1) return 0;
+    
+    unsigned char codigo = (unsigned char)datos[0];
+    int longitud = 1;
+    
+    switch (codigo & ~BINARIO_CON_CRC) {
+        case BINARIO_LOAD:
+            longitud = 2;
+            break;
+        case BINARIO_MAP:
+            // Bytes del varint: el bit alto indica que sigue otro
+            while (true) {
+                if (longitud == 6) return -1;
+                if (longitud >= disponibles) return 0;
+                if (((unsigned char)datos[longitud++] & 0x80) == 0) break;
+            }
+            break;
+        case BINARIO_FIN:
+            break;
+        default:
+            return -1;
+    }
+    
+    if (codigo & BINARIO_CON_CRC) longitud++;
+    
+    return longitud <= disponibles ? longitud : 0;
+}
+
+/**
+ * @brief Analiza una trama binaria completa (medida con medirTramaBinaria())
+ * @param datos Inicio de la trama
+ * @param longitud Longitud de la trama
+ * @param trama Recibe el tipo y los datos (TRAMA_FIN para el código FIN)
+ * @return true si la trama es válida y su CRC, si lo trae, coincide
+ */
+inline bool analizarTramaBinaria(const char* datos, int longitud, Trama& trama) {
+    trama.tipo = TRAMA_INVALIDA;
+    
+    if (longitud < 1 || medirTramaBinaria(datos, longitud) != longitud) return false;
+    
+    unsigned char codigo = (unsigned char)datos[0];
+    if (codigo & BINARIO_CON_CRC) {
+        longitud--;
+        if (crc8(datos, longitud) != (unsigned char)datos[longitud]) return false;
+    }
+    
+    switch (codigo & ~BINARIO_CON_CRC) {
+        case BINARIO_LOAD:
+            trama.caracter = datos[1];
+            trama.tipo = TRAMA_LOAD;
+            return true;
+        case BINARIO_MAP: {
+            unsigned int valor = 0;
+            for (int i = 1; i < longitud; i++) {
+                valor |= (unsigned int)((unsigned char)datos[i] & 0x7F) << (7 * (i - 1));
+            }
+            // Zigzag: 0, -1, 1, -2, 2... -> 0, 1, 2, 3, 4...
+            trama.rotacion = (int)(valor >> 1) ^ -(int)(valor & 1);
+            trama.tipo = TRAMA_MAP;
+            return true;
+        }
+        case BINARIO_FIN:
+            trama.tipo = TRAMA_FIN;
+            return true;
+    }
+    
+    return false;
+}
+
+/**
+ * @brief Aplica un corrimiento de César sobre A-Z a un bloque de bytes
+ * * Los bytes fuera de A-Z (como el espacio) se copian sin cambios. Usa
+ * AVX2, SSE2 o NEON según el objetivo de compilación, con un ciclo escalar
+ * para el resto y como alternativa portable.
+ * @param datos Bytes a traducir (se modifican en el lugar)
+ * @param cantidad Número de bytes
+ * @param desplazamiento Corrimiento en [0, 26)
+ */
+inline void desplazarMayusculas(char* datos, int cantidad, int desplazamiento) {
+    int i = 0;
+    
+#if defined(__AVX2__)
+    const __m256i letraA = _mm256_set1_epi8('A');
+    const __m256i menosUno = _mm256_set1_epi8(-1);
+    const __m256i veintiseis = _mm256_set1_epi8(26);
+    const __m256i veinticinco = _mm256_set1_epi8(25);
+    const __m256i corrimiento = _mm256_set1_epi8((char)desplazamiento);
+    
+    for (; i + 32 <= cantidad; i += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(datos + i));
+        __m256i t = _mm256_sub_epi8(v, letraA);
+        __m256i esLetra = _mm256_and_si256(_mm256_cmpgt_epi8(t, menosUno),
+                                           _mm256_cmpgt_epi8(veintiseis, t));
+        __m256i r = _mm256_add_epi8(t, corrimiento);
+        r = _mm256_sub_epi8(r, _mm256_and_si256(_mm256_cmpgt_epi8(r, veinticinco), veintiseis));
+        r = _mm256_add_epi8(r, letraA);
+        v = _mm256_blendv_epi8(v, r, esLetra);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(datos + i), v);
+    }
+#elif defined(PRT7_SSE2)
+    const __m128i letraA = _mm_set1_epi8('A');
+    const __m128i menosUno = _mm_set1_epi8(-1);
+    const __m128i veintiseis = _mm_set1_epi8(26);
+    const __m128i veinticinco = _mm_set1_epi8(25);
+    const __m128i corrimiento = _mm_set1_epi8((char)desplazamiento);
+    
+    for (; i + 16 <= cantidad; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(datos + i));
+        __m128i t = _mm_sub_epi8(v, letraA);
+        __m128i esLetra = _mm_and_si128(_mm_cmpgt_epi8(t, menosUno),
+                                        _mm_cmplt_epi8(t, veintiseis));
+        __m128i r = _mm_add_epi8(t, corrimiento);
+        r = _mm_sub_epi8(r, _mm_and_si128(_mm_cmpgt_epi8(r, veinticinco), veintiseis));
+        r = _mm_add_epi8(r, letraA);
+        v = _mm_or_si128(_mm_and_si128(esLetra, r), _mm_andnot_si128(esLetra, v));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(datos + i), v);
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    const uint8x16_t letraA = vdupq_n_u8('A');
+    const uint8x16_t veintiseis = vdupq_n_u8(26);
+    const uint8x16_t corrimiento = vdupq_n_u8((uint8_t)desplazamiento);
+    
+    for (; i + 16 <= cantidad; i += 16) {
+        uint8_t* p = reinterpret_cast<uint8_t*>(datos + i);
+        uint8x16_t v = vld1q_u8(p);
+        uint8x16_t t = vsubq_u8(v, letraA);
+        uint8x16_t esLetra = vcltq_u8(t, veintiseis);
+        uint8x16_t r = vaddq_u8(t, corrimiento);
+        r = vsubq_u8(r, vandq_u8(vcgeq_u8(r, veintiseis), veintiseis));
+        r = vaddq_u8(r, letraA);
+        vst1q_u8(p, vbslq_u8(esLetra, r, v));
+    }
+#endif
+    
+    // Resto (o todo el bloque sin SIMD)
+    for (; i < cantidad; i++) {
+        unsigned char t = (unsigned char)(datos[i] - 'A');
+        if (t < 26) {
+            int r = t + desplazamiento;
+            datos[i] = (char)('A' + (r >= 26 ? r - 26 : r));
+        }
+    }
+}
+
+/**
+ * @brief Traduce en el lugar un bloque de caracteres LOAD con el rotor
+ * * Versión general: un getMapeo() por carácter.
+ */
+template <typename Rotor>
+inline void traducirBloque(Rotor& rotor, char* datos, int cantidad) {
+    for (int i = 0; i < cantidad; i++) {
+        datos[i] = rotor.getMapeo(datos[i]);
+    }
+}
+
+/**
+ * @brief Traduce en el lugar un bloque de caracteres LOAD con el rotor
+ * * El rotor indexado es un corrimiento de César puro sobre A-Z, así que
+ * todo el bloque se traduce con el núcleo vectorizado.
+ */
+inline void traducirBloque(RotorIndexado& rotor, char* datos, int cantidad) {
+    desplazarMayusculas(datos, cantidad, rotor.getDesplazamiento());
+}
+
+/**
+ * @brief Resultado de decodificar un bloque de texto PRT-7
+ */
+struct EstadisticasLote {
+    long long lineas;           ///< Líneas no vacías examinadas
+    long long tramasLoad;       ///< Tramas LOAD aplicadas
+    long long tramasMap;        ///< Tramas MAP aplicadas
+    long long malformadas;      ///< Líneas que no son trama ni control
+    long long control;          ///< Mensajes de control (saludo del sistema)
+    size_t bytesConsumidos;     ///< Bytes procesados, incluyendo la línea FIN
+    bool finEncontrado;         ///< true si el bloque terminó en una trama FIN
+    
+    EstadisticasLote()
+        : lineas(0), tramasLoad(0), tramasMap(0), malformadas(0), control(0),
+          bytesConsumidos(0), finEncontrado(false) {}
+};
+
+/**
+ * @brief Decodifica un bloque completo de líneas PRT-7 en una sola pasada
+ * * No imprime nada. Las tramas MAP no se aplican en el momento: se suman
+ * en una rotación pendiente (módulo el tamaño del rotor) que se aplica
+ * solo cuando la siguiente LOAD necesita el mapeo. Así, MAP consecutivos
+ * cuestan una única rotación y los que se anulan (como "M,5" ... "M,-5")
+ * no cortan la racha. Los caracteres de cada racha de LOAD con el rotor
+ * fijo se traducen juntos con traducirBloque() y se insertan en bloque.
+ * Se detiene después de la primera trama FIN; el llamador
+ * puede continuar desde bytesConsumidos para procesar el siguiente ciclo.
+ * @param datos Texto con líneas "L,x" / "M,n" separadas por '\n'
+ * @param longitud Cantidad de bytes de datos
+ * @param carga Lista donde se insertan los caracteres decodificados
+ * @param rotor Rotor de mapeo (cualquier motor con rotar/getMapeo)
+ * @return Estadísticas de lo procesado
+ */
+template <typename Rotor>
+EstadisticasLote decodificarLote(const char* datos, size_t longitud,
+                                 ListaDeCarga& carga, Rotor& rotor) {
+    static const int MAX_RACHA = 512;
+    static const int ROTORES = RotoresDe<Rotor>::CANTIDAD;
+    
+    EstadisticasLote stats;
+    size_t pos = 0;
+    Trama trama;
+    char racha[MAX_RACHA];
+    int enRacha = 0;
+    const int simbolos = rotor.getTamanio();
+    int pendiente[ROTORES];     // Rotación neta aún no aplicada a cada rotor, en [0, simbolos)
+    bool hayPendiente = false;  // Algún pendiente[k] es distinto de 0
+    
+    for (int k = 0; k < ROTORES; k++) {
+        pendiente[k] = 0;
+    }
+    
+    while (pos < longitud) {
+        // 1. Delimitar la línea [pos, finLinea)
+        const char* inicio = datos + pos;
+        const char* salto = static_cast<const char*>(
+            std::memchr(inicio, '\n', longitud - pos));
+        size_t finLinea = salto ? (size_t)(salto - datos) : longitud;
+        int largo = (int)(finLinea - pos);
+        
+        pos = salto ? finLinea + 1 : longitud;
+        
+        if (largo > 0 && inicio[largo - 1] == '\r') largo--;
+        if (largo == 0) continue;
+        
+        stats.lineas++;
+        
+        // 2. Aplicar la trama directamente sobre las estructuras
+        bool terminar = false;
+        
+        switch (clasificarLinea(inicio, largo, trama)) {
+            case TRAMA_LOAD:
+                if (hayPendiente) {
+                    // La racha se traduce con el rotor anterior a la rotación
+                    if (enRacha > 0) {
+                        traducirBloque(rotor, racha, enRacha);
+                        carga.insertarBloque(racha, enRacha);
+                        enRacha = 0;
+                    }
+                    for (int k = 0; k < ROTORES; k++) {
+                        if (pendiente[k] != 0) {
+                            rotarRotor(rotor, k, pendiente[k]);
+                            pendiente[k] = 0;
+                        }
+                    }
+                    hayPendiente = false;
+                }
+                
+                racha[enRacha++] = trama.caracter;
+                stats.tramasLoad++;
+                
+                if (enRacha == MAX_RACHA) {
+                    traducirBloque(rotor, racha, enRacha);
+                    carga.insertarBloque(racha, enRacha);
+                    enRacha = 0;
+                }
+                break;
+                
+            case TRAMA_MAP:
+                // Las rotaciones de rotores distintos conmutan entre sí; las
+                // dirigidas a un rotor que no existe se ignoran
+                if (simbolos > 0 && trama.destino < ROTORES) {
+                    int& neta = pendiente[trama.destino];
+                    neta = (neta + trama.rotacion % simbolos + simbolos) % simbolos;
+                    
+                    // Si las rotaciones se anularon, la racha sigue con el mismo rotor
+                    hayPendiente = false;
+                    for (int k = 0; k < ROTORES; k++) {
+                        if (pendiente[k] != 0) hayPendiente = true;
+                    }
+                }
+                stats.tramasMap++;
+                break;
+                
+            case TRAMA_FIN:
+                stats.finEncontrado = true;
+                terminar = true;
+                break;
+                
+            case TRAMA_SALUDO:
+            case TRAMA_MODO_BINARIO:
+                stats.control++;
+                break;
+                
+            case TRAMA_INVALIDA:
+                stats.malformadas++;
+                break;
+        }
+        
+        if (terminar) break;
+    }
+    
+    if (enRacha > 0) {
+        traducirBloque(rotor, racha, enRacha);
+        carga.insertarBloque(racha, enRacha);
+    }
+    
+    // Dejar el rotor en el estado que indican todas las MAP procesadas
+    for (int k = 0; k < ROTORES; k++) {
+        if (pendiente[k] != 0) {
+            rotarRotor(rotor, k, pendiente[k]);
+        }
+    }
+    
+    stats.bytesConsumidos = pos;
+    return stats;
+}
+
+/**
+ * @brief Resumen de un tramo de texto PRT-7 usado por la decodificación paralela
+ */
+struct ResumenTramo {
+    int rotacionNeta;   ///< Suma de las MAP del tramo, en [0, simbolos)
+    size_t finLinea;    ///< Inicio de la línea FIN dentro del tramo, o la longitud
+    bool tieneFin;      ///< true si el tramo contiene una trama FIN
+    
+    ResumenTramo() : rotacionNeta(0), finLinea(0), tieneFin(false) {}
+};
+
+/**
+ * @brief Calcula la rotación neta de un tramo sin decodificar sus LOAD
+ * @param datos Inicio del tramo
+ * @param longitud Bytes del tramo
+ * @param simbolos Tamaño del rotor (módulo de la rotación)
+ */
+inline ResumenTramo resumirTramo(const char* datos, size_t longitud, int simbolos) {
+    ResumenTramo resumen;
+    size_t pos = 0;
+    resumen.finLinea = longitud;
+    
+    while (pos < longitud) {
+        const char* inicio = datos + pos;
+        const char* salto = static_cast<const char*>(
+            std::memchr(inicio, '\n', longitud - pos));
+        int largo = (int)((salto ? (size_t)(salto - datos) : longitud) - pos);
+        size_t inicioLinea = pos;
+        
+        pos = salto ? (size_t)(salto - datos) + 1 : longitud;
+        
+        if (largo > 0 && inicio[largo - 1] == '\r') largo--;
+        
+        Trama trama;
+        TipoTrama tipo = clasificarLinea(inicio, largo, trama);
+        if (tipo == TRAMA_MAP) {
+            // Solo el primer rotor existe en un rotor simple
+            if (trama.destino == 0) {
+                resumen.rotacionNeta = (resumen.rotacionNeta + trama.rotacion % simbolos + simbolos) % simbolos;
+            }
+        } else if (tipo == TRAMA_FIN) {
+            resumen.tieneFin = true;
+            resumen.finLinea = inicioLinea;
+            break;
+        }
+    }
+    
+    return resumen;
+}
+
+/**
+ * @brief Espera a todos los hilos lanzados y vacía el vector
+ */
+inline void unirHilos(std::vector<std::thread>& hilos) {
+    for (size_t i = 0; i < hilos.size(); i++) {
+        hilos[i].join();
+    }
+    hilos.clear();
+}
+
+/**
+ * @brief Decodifica un bloque grande de texto PRT-7 usando varios hilos
+ * * El estado del rotor en cualquier trama es la suma de todas las MAP
+ * anteriores módulo el tamaño del rotor, así que:
+ * 1. Se divide la entrada en tramos que terminan en fin de línea.
+ * 2. En paralelo se calcula la rotación neta de cada tramo; una suma de
+ *    prefijos da la rotación inicial de cada uno.
+ * 3. En paralelo se decodifica cada tramo con decodificarLote() en su
+ *    propia ListaDeCarga y su propio rotor.
+ * 4. Los segmentos se empalman en orden con concatenar(), en O(1) cada uno.
+ *
+ * El resultado (mensaje, estado final del rotor y estadísticas) es el mismo
+ * que el de decodificarLote() sobre toda la entrada. Con una cascada de varios
+ * rotores, o si el sistema no puede crear un hilo, se decodifica en un solo
+ * hilo.
+ * @param datos Texto con líneas PRT-7
+ * @param longitud Bytes de datos
+ * @param carga Lista donde se agregan los caracteres decodificados
+ * @param rotor Rotor con el estado inicial; queda con el estado final
+ * @param hilos Cantidad de hilos (0 = todos los núcleos disponibles)
+ */
+template <typename Rotor>
+EstadisticasLote decodificarParalelo(const char* datos, size_t longitud,
+                                     ListaDeCarga& carga, Rotor& rotor, int hilos) {
+    static const size_t MIN_BYTES_POR_TRAMO = 1 << 16;
+    
+    if (hilos <= 0) {
+        hilos = (int)std::thread::hardware_concurrency();
+    }
+    if (hilos <= 0) {
+        hilos = 1;
+    }
+    if ((size_t)hilos > longitud / MIN_BYTES_POR_TRAMO) {
+        hilos = (int)(longitud / MIN_BYTES_POR_TRAMO);
+    }
+    const int simbolos = rotor.getTamanio();
+    // Con varios rotores el estado ya no es una sola suma de prefijos
+    if (hilos <= 1 || simbolos <= 0 || RotoresDe<Rotor>::CANTIDAD > 1) {
+        return decodificarLote(datos, longitud, carga, rotor);
+    }
+    
+    std::vector<size_t> inicios(hilos + 1);
+    std::vector<ResumenTramo> resumenes(hilos);
+    std::vector<EstadisticasLote> parciales(hilos);
+    std::vector<ListaDeCarga> segmentos(hilos);
+    std::vector<std::thread> trabajadores;
+    trabajadores.reserve(hilos);
+    
+    // 1. Cortar en tramos que terminan justo después de un '\n'
+    inicios[0] = 0;
+    for (int i = 1; i < hilos; i++) {
+        size_t corte = longitud / hilos * i;
+        if (corte < inicios[i - 1]) corte = inicios[i - 1];
+        
+        const char* salto = static_cast<const char*>(
+            std::memchr(datos + corte, '\n', longitud - corte));
+        inicios[i] = salto ? (size_t)(salto - datos) + 1 : longitud;
+    }
+    inicios[hilos] = longitud;
+    
+    // 2. Rotación neta de cada tramo, en paralelo
+    // Los hilos usan los vectores por referencia: no cambian de tamaño mientras corren
+    bool lanzados = true;
+    try {
+        for (int i = 0; i < hilos; i++) {
+            trabajadores.push_back(std::thread([=, &inicios, &resumenes]() {
+                resumenes[i] = resumirTramo(datos + inicios[i], inicios[i + 1] - inicios[i], simbolos);
+            }));
+        }
+    } catch (const std::system_error&) {
+        lanzados = false;
+    }
+    unirHilos(trabajadores);
+    // Sin hilos (límite del sistema) se decodifica en el llamador; carga y rotor siguen intactos
+    if (!lanzados) return decodificarLote(datos, longitud, carga, rotor);
+    
+    // Solo cuentan los tramos hasta el primero que contiene FIN
+    int ultimo = hilos - 1;
+    for (int i = 0; i < hilos; i++) {
+        if (resumenes[i].tieneFin) {
+            ultimo = i;
+            break;
+        }
+    }
+    
+    // 3. Suma de prefijos y decodificación de cada tramo, en paralelo
+    int desplazamiento = rotor.getDesplazamiento();
+    try {
+        for (int i = 0; i <= ultimo; i++) {
+            const int inicial = desplazamiento;
+            trabajadores.push_back(std::thread([=, &inicios, &parciales, &segmentos]() {
+                Rotor local;
+                local.rotar(inicial);
+                parciales[i] = decodificarLote(datos + inicios[i], inicios[i + 1] - inicios[i],
+                                               segmentos[i], local);
+            }));
+            desplazamiento = (desplazamiento + resumenes[i].rotacionNeta) % simbolos;
+        }
+    } catch (const std::system_error&) {
+        lanzados = false;
+    }
+    unirHilos(trabajadores);
+    if (!lanzados) return decodificarLote(datos, longitud, carga, rotor);
+    
+    // 4. Empalmar los segmentos y combinar las estadísticas
+    EstadisticasLote stats;
+    for (int i = 0; i <= ultimo; i++) {
+        carga.concatenar(segmentos[i]);
+        
+        stats.lineas += parciales[i].lineas;
+        stats.tramasLoad += parciales[i].tramasLoad;
+        stats.tramasMap += parciales[i].tramasMap;
+        stats.malformadas += parciales[i].malformadas;
+        stats.control += parciales[i].control;
+        stats.bytesConsumidos = inicios[i] + parciales[i].bytesConsumidos;
+        stats.finEncontrado = parciales[i].finEncontrado;
+    }
+    
+    rotor.rotar(desplazamiento - rotor.getDesplazamiento());
+    
+    return stats;
+}
+
+/**
+ * @brief Parsea una línea del serial y crea la trama correspondiente
+ * @return Trama reservada con new (el llamador debe liberarla) o nullptr
+ */
+inline TramaBase* parsearTrama(char* linea) {
+    Trama trama;
+    
+    if (!analizarTrama(linea, (int)std::strlen(linea), trama)) {
+        return nullptr;
+    }
+    
+    if (trama.tipo == TRAMA_LOAD) {
+        return new TramaLoad(trama.caracter);
+    }
+    
+    return new TramaMap(trama.rotacion, trama.destino);
+}
+
+/**
+ * @brief Tipos de evento que produce DecodificadorPRT7
+ */
+enum TipoEvento {
+    EVENTO_FRAGMENTO,       ///< LOAD decodificado e insertado en la carga
+    EVENTO_ROTACION,        ///< MAP aplicado al rotor
+    EVENTO_CONTROL,         ///< Saludo "SISTEMA PRT-7 ACTIVO"
+    EVENTO_MODO_BINARIO,    ///< El emisor pasó al formato binario
+    EVENTO_MALFORMADA,      ///< Línea o trama que no se pudo analizar
+    EVENTO_FIN              ///< Mensaje completo en getCarga()
+};
+
+/**
+ * @brief Evento producido al decodificar una línea o trama
+ */
+struct EventoPRT7 {
+    TipoEvento tipo;
+    char recibido;          ///< EVENTO_FRAGMENTO: carácter de la trama
+    char decodificado;      ///< EVENTO_FRAGMENTO: carácter insertado
+    int rotacion;           ///< EVENTO_ROTACION: posiciones rotadas
+    int destino;            ///< EVENTO_ROTACION: rotor de la cascada (0 = el primero)
+    char cabeza;            ///< EVENTO_ROTACION: a qué se mapea 'A' ahora
+    const char* datos;      ///< Bytes de la línea/trama; válidos hasta la siguiente llamada
+    int longitud;           ///< Cantidad de bytes en datos
+    
+    EventoPRT7()
+        : tipo(EVENTO_MALFORMADA), recibido('\0'), decodificado('\0'), rotacion(0),
+          destino(0), cabeza('\0'), datos(nullptr), longitud(0) {}
+};
+
+/**
+ * @brief Decodificador PRT-7 sin bloqueos para integrar en un bucle de eventos
+ * * No lee de ninguna fuente ni imprime nada: el llamador le entrega los
+ * bytes que ya recibió (alimentar()) y retira los eventos decodificados
+ * (siguienteEvento()). Cada instancia tiene su propia ListaDeCarga y su
+ * RotorDeMapeo, así que un solo hilo puede atender muchos decodificadores.
+ * Entiende el formato de texto y, después de "MODO BINARIO", el binario.
+ * Después de EVENTO_FIN, el mensaje queda en getCarga() hasta reiniciar().
+ */
+class DecodificadorPRT7 {
+public:
+    static const int CAPACIDAD = 4096;
+    
+private:
+    char buffer[CAPACIDAD];
+    int inicio;         // Primer byte sin consumir
+    int fin;            // Fin de los datos válidos
+    int revisado;       // Hasta dónde ya se buscó el '\n'
+    bool binario;
+    bool entradaCerrada;
+    bool descartando;   // Se entregó una línea truncada y falta su '\n'
+    ListaDeCarga carga;
+    RotorDeMapeo rotor;
+    
+    /**
+     * @brief Mueve los bytes pendientes al inicio del buffer
+     */
+    void compactar() {
+        int pendientes = fin - inicio;
+        std::memmove(buffer, &buffer[inicio], (size_t)pendientes);
+        revisado -= inicio;
+        inicio = 0;
+        fin = pendientes;
+    }
+    
+    /**
+     * @brief Delimita la siguiente línea de texto no vacía
+     * * Una línea que no cabe en el buffer se entrega una sola vez, con
+     * truncada en true, y el resto se descarta hasta el siguiente '\n'.
+     * @return false si todavía no hay una línea completa
+     */
+    bool delimitarLinea(const char*& linea, int& longitud, bool& truncada) {
+        while (true) {
+            int finLinea = -1;
+            
+            while (revisado < fin) {
+                if (buffer[revisado] == '\n') {
+                    finLinea = revisado;
+                    break;
+                }
+                revisado++;
+            }
+            
+            int siguiente;
+            truncada = false;
+            if (finLinea >= 0) {
+                siguiente = finLinea + 1;
+            } else if (fin - inicio == CAPACIDAD) {
+                // Línea más larga que el buffer
+                finLinea = siguiente = fin;
+                truncada = true;
+            } else if (entradaCerrada && fin > inicio) {
+                // La última línea sin '\n'
+                finLinea = siguiente = fin;
+            } else {
+                return false;
+            }
+            
+            linea = &buffer[inicio];
+            longitud = finLinea - inicio;
+            if (longitud > 0 && linea[longitud - 1] == '\r') longitud--;
+            inicio = revisado = siguiente;
+            
+            // El resto de una línea ya entregada como truncada no se entrega
+            bool resto = descartando;
+            descartando = truncada;
+            if (resto) continue;
+            
+            if (longitud > 0) return true;
+        }
+    }
+    
+    /**
+     * @brief Aplica una trama ya analizada y describe el resultado
+     */
+    void aplicar(const Trama& trama, EventoPRT7& evento) {
+        switch (trama.tipo) {
+            case TRAMA_LOAD:
+                evento.tipo = EVENTO_FRAGMENTO;
+                evento.recibido = trama.caracter;
+                evento.decodificado = rotor.getMapeo(trama.caracter);
+                carga.insertarAlFinal(evento.decodificado);
+                break;
+            case TRAMA_MAP:
+                rotarRotor(rotor, trama.destino, trama.rotacion);
+                evento.tipo = EVENTO_ROTACION;
+                evento.rotacion = trama.rotacion;
+                evento.destino = trama.destino;
+                evento.cabeza = rotor.getCabeza();
+                break;
+            case TRAMA_FIN:
+                evento.tipo = EVENTO_FIN;
+                break;
+            case TRAMA_SALUDO:
+                evento.tipo = EVENTO_CONTROL;
+                break;
+            case TRAMA_MODO_BINARIO:
+                evento.tipo = EVENTO_MODO_BINARIO;
+                binario = true;
+                break;
+            case TRAMA_INVALIDA:
+                evento.tipo = EVENTO_MALFORMADA;
+                break;
+        }
+    }
+    
+public:
+    DecodificadorPRT7()
+        : inicio(0), fin(0), revisado(0), binario(false), entradaCerrada(false), descartando(false),
+          carga(IMPRESION_SILENCIOSA) {}
+    
+    DecodificadorPRT7(const DecodificadorPRT7&) = delete;
+    DecodificadorPRT7& operator=(const DecodificadorPRT7&) = delete;
+    
+    /**
+     * @brief Entrega bytes recibidos; no decodifica nada todavía
+     * @return Bytes aceptados; menos que longitud si el buffer está lleno,
+     *         en cuyo caso hay que retirar eventos y volver a llamar
+     */
+    int alimentar(const char* datos, int longitud) {
+        if (CAPACIDAD - fin < longitud && inicio > 0) {
+            compactar();
+        }
+        
+        int libres = CAPACIDAD - fin;
+        int copiados = longitud < libres ? longitud : libres;
+        std::memcpy(&buffer[fin], datos, (size_t)copiados);
+        fin += copiados;
+        return copiados;
+    }
+    
+    /**
+     * @brief Entrega bytes y pasa cada evento resultante a un manejador
+     * * Consume todos los bytes, alternando entre alimentar() y
+     * siguienteEvento() cuando el buffer se llena.
+     * @param manejador Invocable como manejador(const EventoPRT7&)
+     * @return Cantidad de eventos producidos
+     */
+    template <typename Manejador>
+    int alimentar(const char* datos, int longitud, Manejador manejador) {
+        EventoPRT7 evento;
+        int eventos = 0;
+        
+        while (true) {
+            int aceptados = alimentar(datos, longitud);
+            datos += aceptados;
+            longitud -= aceptados;
+            
+            while (siguienteEvento(evento)) {
+                manejador(evento);
+                eventos++;
+            }
+            
+            if (longitud == 0) return eventos;
+        }
+    }
+    
+    /**
+     * @brief Indica que no llegarán más bytes
+     * * La última línea de texto sin '\n' pasa a poder retirarse como evento.
+     */
+    void cerrarEntrada() {
+        entradaCerrada = true;
+    }
+    
+    /**
+     * @brief Decodifica la siguiente línea o trama completa del buffer
+     * @param evento Recibe lo ocurrido
+     * @return false si no hay una línea o trama completa pendiente
+     */
+    bool siguienteEvento(EventoPRT7& evento) {
+        Trama trama;
+        evento = EventoPRT7();
+        
+        if (binario) {
+            int longitud = medirTramaBinaria(&buffer[inicio], fin - inicio);
+            
+            if (longitud == 0) {
+                // Trama incompleta: dejar lugar para el resto
+                if (fin == CAPACIDAD && inicio > 0) compactar();
+                return false;
+            }
+            
+            evento.datos = &buffer[inicio];
+            if (longitud < 0) {
+                // Código inválido: se descarta un byte para resincronizar
+                evento.longitud = 1;
+                inicio = revisado = inicio + 1;
+                return true;
+            }
+            
+            evento.longitud = longitud;
+            inicio = revisado = inicio + longitud;
+            
+            if (!analizarTramaBinaria(evento.datos, longitud, trama)) {
+                trama.tipo = TRAMA_INVALIDA;
+            }
+            aplicar(trama, evento);
+            return true;
+        }
+        
+        const char* linea;
+        int longitud;
+        bool truncada;
+        
+        if (!delimitarLinea(linea, longitud, truncada)) {
+            if (fin == CAPACIDAD && inicio > 0) compactar();
+            return false;
+        }
+        
+        evento.datos = linea;
+        evento.longitud = longitud;
+        if (truncada) {
+            // Recortada podría pasar por otra trama válida: EVENTO_MALFORMADA
+            return true;
+        }
+        clasificarLinea(linea, longitud, trama);
+        aplicar(trama, evento);
+        return true;
+    }
+    
+    /**
+     * @brief Descarta el mensaje y vuelve el rotor a su posición inicial
+     * * Los nodos vuelven al pool (ver ListaDeCarga::vaciar()); los bytes
+     * pendientes y el formato (texto o binario) se conservan.
+     */
+    void reiniciar() {
+        carga.vaciar();
+        rotor.reiniciar();
+    }
+    
+    const ListaDeCarga& getCarga() const {
+        return carga;
+    }
+    
+    const RotorDeMapeo& getRotor() const {
+        return rotor;
+    }
+    
+    bool esBinario() const {
+        return binario;
+    }
+    
+    /**
+     * @brief Bytes recibidos que todavía no forman parte de ningún evento
+     */
+    int getPendientes() const {
+        return fin - inicio;
+    }
+};
+
+/**
+ * @brief Reloj monotónico en nanosegundos para la instrumentación
+ */
+inline unsigned long long relojNs() {
+    return (unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief Histograma de latencias con error relativo acotado (estilo HDR)
+ * * Cada potencia de 2 se reparte en MITAD cubetas lineales, así que
+ * cualquier percentil se reporta con menos de 1/MITAD (~3%) de error
+ * relativo, desde 1 ns hasta MAXIMO_NS, con memoria fija y registro en O(1).
+ */
+class HistogramaLatencia {
+public:
+    static const int BITS_SUBCUBETA = 6;
+    static const int SUBCUBETAS = 1 << BITS_SUBCUBETA;         // 64
+    static const int MITAD = SUBCUBETAS / 2;                   // 32
+    static const int BITS_MAXIMO = 41;                         // 2^41 ns ~ 36 min
+    static const int CUBETAS = (BITS_MAXIMO - BITS_SUBCUBETA) * MITAD + SUBCUBETAS;
+    static const unsigned long long MAXIMO_NS = (1ULL << BITS_MAXIMO) - 1;
+    
+private:
+    unsigned long long cuentas[CUBETAS];
+    unsigned long long total;
+    unsigned long long suma;
+    unsigned long long minimo;
+    unsigned long long maximo;
+    
+    /**
+     * @brief Posición del bit más alto encendido (v > 0)
+     */
+    static int bitMasAlto(unsigned long long v) {
+        #if defined(__GNUC__) || defined(__clang__)
+            return 63 - __builtin_clzll(v);
+        #else
+            int bit = 0;
+            while (v >>= 1) bit++;
+            return bit;
+        #endif
+    }
+    
+    /**
+     * @brief Corrimiento de la cubeta de un valor: 0 para valores < SUBCUBETAS
+     */
+    static int corrimiento(unsigned long long v) {
+        if (v < (unsigned long long)SUBCUBETAS) return 0;
+        return bitMasAlto(v) - BITS_SUBCUBETA + 1;
+    }
+    
+    static int indiceDe(unsigned long long v) {
+        int c = corrimiento(v);
+        return c * MITAD + (int)(v >> c);
+    }
+    
+    /**
+     * @brief Valor representativo (centro) de una cubeta
+     */
+    static unsigned long long valorDe(int indice) {
+        if (indice < SUBCUBETAS) return (unsigned long long)indice;
+        int c = indice / MITAD - 1;
+        unsigned long long inferior = (unsigned long long)(indice - c * MITAD) << c;
+        return inferior + ((1ULL << c) >> 1);
+    }
+    
+public:
+    HistogramaLatencia() {
+        reiniciar();
+    }
+    
+    void reiniciar() {
+        std::memset(cuentas, 0, sizeof(cuentas));
+        total = suma = maximo = 0;
+        minimo = MAXIMO_NS;
+    }
+    
+    /**
+     * @brief Registra una muestra (se satura en MAXIMO_NS)
+     */
+    void registrar(unsigned long long ns) {
+        if (ns > MAXIMO_NS) ns = MAXIMO_NS;
+        
+        cuentas[indiceDe(ns)]++;
+        total++;
+        suma += ns;
+        if (ns < minimo) minimo = ns;
+        if (ns > maximo) maximo = ns;
+    }
+    
+    unsigned long long getCuenta() const {
+        return total;
+    }
+    
+    unsigned long long getMinimo() const {
+        return total ? minimo : 0;
+    }
+    
+    unsigned long long getMaximo() const {
+        return maximo;
+    }
+    
+    unsigned long long getPromedio() const {
+        return total ? suma / total : 0;
+    }
+    
+    /**
+     * @brief Valor bajo el cual queda el porcentaje indicado de muestras
+     * @param porcentaje Entre 0 y 100 (por ejemplo, 99.9)
+     */
+    unsigned long long percentil(double porcentaje) const {
+        if (total == 0) return 0;
+        
+        unsigned long long objetivo = (unsigned long long)(porcentaje / 100.0 * (double)total + 0.5);
+        if (objetivo < 1) objetivo = 1;
+        if (objetivo >= total) return maximo;
+        
+        unsigned long long acumulado = 0;
+        for (int i = 0; i < CUBETAS; i++) {
+            acumulado += cuentas[i];
+            if (acumulado >= objetivo) {
+                unsigned long long valor = valorDe(i);
+                // El centro de la cubeta nunca sale del rango observado
+                if (valor < minimo) valor = minimo;
+                if (valor > maximo) valor = maximo;
+                return valor;
+            }
+        }
+        
+        return maximo;
+    }
+};
+
+#endif // DECODIFICADOR_PRT7_H
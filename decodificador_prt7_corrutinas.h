@@ -0,0 +1,207 @@
+/**
+ * @file decodificador_prt7_corrutinas.h
+ * @brief Envoltura con corrutinas de C++20 sobre DecodificadorPRT7
+ * @author Sistema de Ciberseguridad Industrial
+ * @date 2025
+ * * Permite escribir la lectura de cada puerto como una corrutina que
+ * espera datos con co_await, mientras un solo hilo (BucleDeLectura) atiende
+ * todos los descriptores con poll(). Solo se compila con soporte de
+ * corrutinas (__cpp_impl_coroutine) y en Linux/Mac; en otro caso el
+ * archivo no declara nada y se sigue usando la API por empuje del núcleo.
+ */
+
+#ifndef DECODIFICADOR_PRT7_CORRUTINAS_H
+#define DECODIFICADOR_PRT7_CORRUTINAS_H
+
+#include "decodificador_prt7.h"
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L && !defined(_WIN32)
+#define PRT7_CORRUTINAS 1
+
+#include <coroutine>
+#include <exception>
+#include <cerrno>
+#include <poll.h>
+#include <unistd.h>
+
+/**
+ * @brief Planificador mínimo: reanuda cada corrutina cuando su descriptor
+ *        tiene datos
+ */
+class BucleDeLectura {
+public:
+    static const int MAX_ESPERAS = 64;
+    
+private:
+    struct Espera {
+        int descriptor;
+        std::coroutine_handle<> corrutina;
+    };
+    
+    Espera esperas[MAX_ESPERAS];
+    int cantidad;
+    
+public:
+    /**
+     * @brief Operación co_await que suspende hasta que haya datos en un descriptor
+     */
+    class EsperaLectura {
+    private:
+        BucleDeLectura& bucle;
+        int descriptor;
+        bool registrada;
+        
+    public:
+        EsperaLectura(BucleDeLectura& b, int d) : bucle(b), descriptor(d), registrada(false) {}
+        
+        bool await_ready() const noexcept {
+            return false;
+        }
+        
+        bool await_suspend(std::coroutine_handle<> corrutina) noexcept {
+            registrada = bucle.registrar(descriptor, corrutina);
+            return registrada;  // Sin lugar en el bucle: seguir sin suspender
+        }
+        
+        /**
+         * @return false si no se pudo esperar (demasiadas corrutinas)
+         */
+        bool await_resume() const noexcept {
+            return registrada;
+        }
+    };
+    
+    BucleDeLectura() : cantidad(0) {}
+    
+    BucleDeLectura(const BucleDeLectura&) = delete;
+    BucleDeLectura& operator=(const BucleDeLectura&) = delete;
+    
+    /**
+     * @brief Anota una corrutina que espera datos en un descriptor
+     * @return false si ya no caben más esperas
+     */
+    bool registrar(int descriptor, std::coroutine_handle<> corrutina) {
+        if (cantidad == MAX_ESPERAS) return false;
+        
+        esperas[cantidad].descriptor = descriptor;
+        esperas[cantidad].corrutina = corrutina;
+        cantidad++;
+        return true;
+    }
+    
+    /**
+     * @brief Devuelve el awaitable para `co_await bucle.esperarLectura(fd)`
+     */
+    EsperaLectura esperarLectura(int descriptor) {
+        return EsperaLectura(*this, descriptor);
+    }
+    
+    /**
+     * @brief Atiende las esperas hasta que no quede ninguna
+     * @param timeoutMs Espera máxima de cada poll() (-1 = sin límite)
+     * @return false si poll() falló
+     */
+    bool ejecutar(int timeoutMs = -1) {
+        while (cantidad > 0) {
+            struct pollfd fds[MAX_ESPERAS];
+            for (int i = 0; i < cantidad; i++) {
+                fds[i].fd = esperas[i].descriptor;
+                fds[i].events = POLLIN;
+                fds[i].revents = 0;
+            }
+            
+            int listos = poll(fds, (nfds_t)cantidad, timeoutMs);
+            if (listos < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            
+            // Sacar primero las esperas listas: al reanudarse, las
+            // corrutinas pueden volver a registrarse
+            std::coroutine_handle<> reanudar[MAX_ESPERAS];
+            int porReanudar = 0;
+            int quedan = 0;
+            
+            for (int i = 0; i < cantidad; i++) {
+                if (fds[i].revents != 0) {
+                    reanudar[porReanudar++] = esperas[i].corrutina;
+                } else {
+                    esperas[quedan++] = esperas[i];
+                }
+            }
+            cantidad = quedan;
+            
+            for (int i = 0; i < porReanudar; i++) {
+                reanudar[i].resume();
+            }
+        }
+        
+        return true;
+    }
+};
+
+/**
+ * @brief Tipo de retorno de una corrutina de decodificación
+ * * Empieza a ejecutarse en cuanto se llama y libera su estado al terminar;
+ * la vida de la corrutina la maneja el BucleDeLectura que la reanuda.
+ */
+struct TareaPRT7 {
+    struct promise_type {
+        TareaPRT7 get_return_object() noexcept {
+            return TareaPRT7();
+        }
+        
+        std::suspend_never initial_suspend() noexcept {
+            return std::suspend_never();
+        }
+        
+        std::suspend_never final_suspend() noexcept {
+            return std::suspend_never();
+        }
+        
+        void return_void() noexcept {}
+        
+        void unhandled_exception() noexcept {
+            std::terminate();
+        }
+    };
+};
+
+/**
+ * @brief Decodifica un descriptor en el bucle hasta su FIN o hasta que se cierre
+ * * Cada vez que hay datos los lee sin bloquearse, se los entrega a
+ * decodificador.alimentar() y le pasa los eventos resultantes a manejador.
+ * @param bucle Bucle que reanuda la corrutina
+ * @param descriptor Puerto, tubería o socket abierto para lectura
+ * @param decodificador Estado de decodificación de ese descriptor
+ * @param manejador Invocable como manejador(const EventoPRT7&)
+ */
+template <typename Manejador>
+TareaPRT7 decodificarDescriptor(BucleDeLectura& bucle, int descriptor,
+                                DecodificadorPRT7& decodificador, Manejador manejador) {
+    char bloque[1024];
+    bool fin = false;
+    
+    while (!fin) {
+        if (!co_await bucle.esperarLectura(descriptor)) break;
+        
+        ssize_t n = read(descriptor, bloque, sizeof(bloque));
+        if (n < 0 && (errno == EINTR || errno == EAGAIN)) continue;
+        
+        if (n <= 0) {
+            // Descriptor cerrado: la última línea sin '\n' también cuenta
+            decodificador.cerrarEntrada();
+            n = 0;
+            fin = true;
+        }
+        
+        decodificador.alimentar(bloque, (int)n, [&](const EventoPRT7& evento) {
+            manejador(evento);
+            if (evento.tipo == EVENTO_FIN) fin = true;
+        });
+    }
+}
+
+#endif // __cpp_impl_coroutine
+
+#endif // DECODIFICADOR_PRT7_CORRUTINAS_H
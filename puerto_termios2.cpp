@@ -0,0 +1,35 @@
+/**
+ * @file puerto_termios2.cpp
+ * @brief Velocidades de puerto serial arbitrarias en Linux (termios2/BOTHER)
+ * @author Sistema de Ciberseguridad Industrial
+ * @date 2025
+ * * <asm/termbits.h> redefine struct termios y choca con <termios.h>, por
+ * eso esta función vive en su propia unidad de traducción.
+ */
+
+#include <asm/termbits.h>
+#include <sys/ioctl.h>
+
+/**
+ * @brief Fija una velocidad fuera de la tabla Bxxxx estándar
+ * @param fd Descriptor del puerto ya configurado con tcsetattr()
+ * @param baudios Velocidad en baudios (por ejemplo, 250000 o 2000000)
+ * @return true si el controlador aceptó la velocidad
+ */
+bool configurarBaudiosArbitrarios(int fd, int baudios) {
+    struct termios2 opciones;
+    
+    if (ioctl(fd, TCGETS2, &opciones) != 0) {
+        return false;
+    }
+    
+    // BOTHER: la velocidad se toma de c_ispeed/c_ospeed en lugar de CBAUD
+    opciones.c_cflag &= ~CBAUD;
+    opciones.c_cflag |= BOTHER;
+    opciones.c_cflag &= ~(CBAUD << IBSHIFT);
+    opciones.c_cflag |= BOTHER << IBSHIFT;
+    opciones.c_ispeed = baudios;
+    opciones.c_ospeed = baudios;
+    
+    return ioctl(fd, TCSETS2, &opciones) == 0;
+}
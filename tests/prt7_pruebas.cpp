@@ -0,0 +1,908 @@
+/**
+ * @file prt7_pruebas.cpp
+ * @brief Pruebas de equivalencia entre los motores del decodificador PRT-7
+ * @author Sistema de Ciberseguridad Industrial
+ * @date 2025
+ * * No depende de bibliotecas externas; cada prueba se registra en ctest
+ * (ver CMakeLists.txt). Uso: `prt7_pruebas [prueba]`; sin argumento corre
+ * todas. Termina con código 0 si todas pasan, o con PRUEBA_OMITIDA si la
+ * prueba pedida no está disponible en esta compilación.
+ */
+
+#include "decodificador_prt7.h"
+#include "decodificador_prt7_corrutinas.h"
+
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief Generador congruencial lineal determinista
+ */
+struct Aleatorio {
+    unsigned long long estado;
+    
+    Aleatorio(unsigned long long semilla) : estado(semilla) {}
+    
+    unsigned int siguiente() {
+        estado = estado * 6364136223846793005ULL + 1442695040888963407ULL;
+        return (unsigned int)(estado >> 33);
+    }
+};
+
+/**
+ * @brief Aplica una línea a los dos rotores y compara su estado completo
+ * * Después de cada trama compara getCabeza() y getMapeo() de los 256
+ * bytes, no solo el carácter de la trama.
+ * @param numero Posición de la línea, para el mensaje de error
+ * @return false (e informa la diferencia) si los rotores difieren
+ */
+bool aplicarYComparar(const std::string& linea, int numero, RotorEnlazado& enlazado, RotorIndexado& indexado) {
+    Trama trama;
+    TipoTrama tipo = clasificarLinea(linea.c_str(), (int)linea.size(), trama);
+    
+    if (tipo == TRAMA_MAP) {
+        rotarRotor(enlazado, trama.destino, trama.rotacion);
+        rotarRotor(indexado, trama.destino, trama.rotacion);
+    }
+    
+    if (enlazado.getCabeza() != indexado.getCabeza()) {
+        std::fprintf(stderr, "Trama %d [%s]: cabeza '%c' (enlazado) != '%c' (indexado)\n",
+                     numero, linea.c_str(), enlazado.getCabeza(), indexado.getCabeza());
+        return false;
+    }
+    
+    for (int c = 0; c < 256; c++) {
+        char a = enlazado.getMapeo((char)c);
+        char b = indexado.getMapeo((char)c);
+        if (a != b) {
+            std::fprintf(stderr, "Trama %d [%s]: getMapeo(0x%02X) = 0x%02X (enlazado) != 0x%02X (indexado)\n",
+                         numero, linea.c_str(), c, (unsigned char)a, (unsigned char)b);
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+/**
+ * @brief Corre una secuencia de líneas por RotorEnlazado y RotorIndexado
+ * @return false si en algún momento difieren
+ */
+bool compararSecuencia(const std::vector<std::string>& lineas) {
+    RotorEnlazado enlazado;
+    RotorIndexado indexado;
+    
+    for (size_t i = 0; i < lineas.size(); i++) {
+        if (!aplicarYComparar(lineas[i], (int)i + 1, enlazado, indexado)) return false;
+    }
+    
+    return true;
+}
+
+/**
+ * @brief RotorEnlazado y RotorSobreAlfabeto<AlfabetoMayusculas> dan el mismo mapeo
+ * * Primero el mensaje de arduino.txt y rotaciones límite (múltiplos del
+ * alfabeto, negativas, cercanas a INT_MAX); luego una secuencia aleatoria
+ * de LOAD y MAP con rotaciones positivas y negativas.
+ */
+bool probarRotores() {
+    static const char* fijas[] = {
+        "SISTEMA PRT-7 ACTIVO",
+        "L,H", "L,E", "L,L", "L,L", "L,O", "L, ", "M,5", "L,W", "L,O", "M,-5", "L,R", "L,L", "L,D",
+        "M,26", "L,A", "M,-26", "L,A", "M,27", "L,Z", "M,-27", "L,Z", "M,-1", "L,A", "M,25", "L,A",
+        "M,0", "L,M", "M,+3", "L,X", "M,-1000", "L,B", "M,1000000", "L,Q",
+        "M,2147483647", "L,C", "M,-2147483647", "L,C", "M,-2147483647", "L,Y",
+        "L,a", "L,5", "L,~", "M,x", "FIN"
+    };
+    std::vector<std::string> lineas(fijas, fijas + sizeof(fijas) / sizeof(fijas[0]));
+    
+    if (!compararSecuencia(lineas)) return false;
+    
+    static const char simbolos[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZaz09 .,-";
+    Aleatorio aleatorio(2025);
+    char texto[32];
+    
+    lineas.clear();
+    for (int i = 0; i < 20000; i++) {
+        unsigned int r = aleatorio.siguiente();
+        
+        if (r % 3 == 0) {
+            // Rotaciones chicas en su mayoría, algunas de hasta ±10^9
+            int n = (r % 7 == 0) ? (int)(aleatorio.siguiente() % 2000000001u) - 1000000000
+                                 : (int)(aleatorio.siguiente() % 201u) - 100;
+            std::snprintf(texto, sizeof(texto), "M,%d", n);
+        } else {
+            std::snprintf(texto, sizeof(texto), "L,%c", simbolos[aleatorio.siguiente() % (sizeof(simbolos) - 1)]);
+        }
+        lineas.push_back(texto);
+    }
+    
+    if (!compararSecuencia(lineas)) return false;
+    
+    std::printf("rotores: %d tramas fijas y %d aleatorias, RotorEnlazado == RotorIndexado\n",
+                (int)(sizeof(fijas) / sizeof(fijas[0])), (int)lineas.size());
+    return true;
+}
+
+/**
+ * @brief RotorIndexado que cuenta las llamadas a traducirBloque()
+ */
+struct RotorContado : RotorIndexado {
+    int bloques;        ///< Llamadas a traducirBloque()
+    int traducidos;     ///< Caracteres traducidos en total
+    
+    RotorContado() : bloques(0), traducidos(0) {}
+};
+
+/**
+ * @brief Sobrecarga que decodificarLote() encuentra para RotorContado
+ */
+void traducirBloque(RotorContado& rotor, char* datos, int cantidad) {
+    rotor.bloques++;
+    rotor.traducidos += cantidad;
+    traducirBloque(static_cast<RotorIndexado&>(rotor), datos, cantidad);
+}
+
+/**
+ * @brief Decodifica un texto con decodificarLote() sobre RotorContado y RotorEnlazado
+ * @param bloquesEsperados Llamadas a traducirBloque() que debe hacer el lote
+ * @return false si el mensaje difiere entre motores o la cantidad de bloques no es la esperada
+ */
+bool verificarLote(const char* nombre, const std::string& texto, int bloquesEsperados) {
+    ListaDeCarga cargaContada(IMPRESION_SILENCIOSA);
+    ListaDeCarga cargaEnlazada(IMPRESION_SILENCIOSA);
+    RotorContado contado;
+    RotorEnlazado enlazado;
+    
+    EstadisticasLote stats = decodificarLote(texto.c_str(), texto.size(), cargaContada, contado);
+    decodificarLote(texto.c_str(), texto.size(), cargaEnlazada, enlazado);
+    
+    if (cargaContada.aCadena() != cargaEnlazada.aCadena()) {
+        std::fprintf(stderr, "%s: mensaje [%s] (indexado) != [%s] (enlazado)\n",
+                     nombre, cargaContada.aCadena().c_str(), cargaEnlazada.aCadena().c_str());
+        return false;
+    }
+    
+    if (contado.bloques != bloquesEsperados || contado.traducidos != stats.tramasLoad) {
+        std::fprintf(stderr, "%s: %d llamadas a traducirBloque con %d caracteres (se esperaban %d con %lld)\n",
+                     nombre, contado.bloques, contado.traducidos, bloquesEsperados, stats.tramasLoad);
+        return false;
+    }
+    
+    return true;
+}
+
+/**
+ * @brief decodificarLote() no corta la racha con rotaciones que se anulan
+ * * "M,5" ... "M,-5" (y "M,30" + "M,-4", iguales módulo 26) dejan el rotor
+ * donde estaba: la racha completa se traduce con una sola llamada a
+ * traducirBloque(). Una rotación neta distinta de 0 sí la corta.
+ */
+bool probarLote() {
+    const std::string anuladas = "SISTEMA PRT-7 ACTIVO\nL,H\nL,E\nL,L\nL,L\nL,O\nL, \nM,5\nM,-5\n"
+                                 "L,W\nL,O\nM,30\nM,-4\nL,R\nL,L\nL,D\nFIN\n";
+    const std::string netas = "L,H\nL,E\nM,5\nL,W\nM,3\nM,-8\nL,O\nFIN\n";
+    
+    if (!verificarLote("rotaciones anuladas", anuladas, 1)) return false;
+    if (!verificarLote("rotaciones netas", netas, 3)) return false;
+    
+    std::printf("lote: las rotaciones que se anulan no cortan la racha de traducirBloque\n");
+    return true;
+}
+
+/**
+ * @brief Comprueba un rotor sobre alfabeto contra el corrimiento calculado a mano
+ * @return false (e informa el símbolo) si alguno no se mapea al que está n
+ *         posiciones adelante
+ */
+template <typename Alfabeto>
+bool verificarAlfabeto(const char* nombre) {
+    RotorSobreAlfabeto<Alfabeto> rotor;
+    const int tamanio = Alfabeto::TAMANIO;
+    int desplazamiento = 0;
+    Aleatorio aleatorio(7);
+    
+    for (int paso = 0; paso < 2000; paso++) {
+        int n = (int)(aleatorio.siguiente() % 2001) - 1000;
+        rotor.rotar(n);
+        desplazamiento = ((desplazamiento + n) % tamanio + tamanio) % tamanio;
+        
+        for (int i = 0; i < tamanio; i++) {
+            char esperado = Alfabeto::simbolo((i + desplazamiento) % tamanio);
+            char obtenido = rotor.getMapeo(Alfabeto::simbolo(i));
+            if (obtenido != esperado) {
+                std::fprintf(stderr, "%s, paso %d: getMapeo(0x%02X) = 0x%02X, se esperaba 0x%02X\n",
+                             nombre, paso, (unsigned char)Alfabeto::simbolo(i), (unsigned char)obtenido,
+                             (unsigned char)esperado);
+                return false;
+            }
+        }
+    }
+    
+    return true;
+}
+
+/**
+ * @brief Los rotores alfanumérico y de bytes rotan como se espera
+ */
+bool probarAlfabetos() {
+    if (!verificarAlfabeto<AlfabetoMayusculas>("mayusculas")) return false;
+    if (!verificarAlfabeto<AlfabetoAlfanumerico>("alfanumerico")) return false;
+    if (!verificarAlfabeto<AlfabetoBytes>("bytes")) return false;
+    
+    std::printf("alfabetos: mayusculas, alfanumerico y bytes correctos\n");
+    return true;
+}
+
+/**
+ * @brief CascadaDeRotores compone los rotores como se espera
+ * * Con cableado identidad, tres rotores equivalen a un RotorIndexado
+ * rotado la suma de los tres; un cableado no trivial se compone en el
+ * orden correcto.
+ */
+bool probarCascada() {
+    CascadaDeRotores<AlfabetoMayusculas, 3> cascada;
+    RotorIndexado indexado;
+    Aleatorio aleatorio(99);
+    
+    for (int paso = 0; paso < 5000; paso++) {
+        int n = (int)(aleatorio.siguiente() % 2001) - 1000;
+        int indice = (int)(aleatorio.siguiente() % 3);
+        rotarRotor(cascada, indice, n);
+        indexado.rotar(n);
+        
+        for (int c = 0; c < 256; c++) {
+            if (cascada.getMapeo((char)c) != indexado.getMapeo((char)c)) {
+                std::fprintf(stderr, "cascada, paso %d (rotor %d, %d): getMapeo(0x%02X) = 0x%02X != 0x%02X\n",
+                             paso, indice, n, c, (unsigned char)cascada.getMapeo((char)c),
+                             (unsigned char)indexado.getMapeo((char)c));
+                return false;
+            }
+        }
+    }
+    
+    // Un rotor con cableado invertido seguido de uno identidad
+    CascadaDeRotores<AlfabetoMayusculas, 2> invertida;
+    if (!invertida.setCableado(0, "ZYXWVUTSRQPONMLKJIHGFEDCBA")) {
+        std::fprintf(stderr, "cascada: setCableado rechazo una permutacion valida\n");
+        return false;
+    }
+    if (invertida.setCableado(1, "AABCDEFGHIJKLMNOPQRSTUVWXY")) {
+        std::fprintf(stderr, "cascada: setCableado acepto un cableado con 'A' repetida\n");
+        return false;
+    }
+    invertida.rotar(0, 1);
+    invertida.rotar(1, 2);
+    // 'A' (0) -> rotor 1 entra por 1 y sale por 'Y' (24) -> rotor 2 suma 2 -> 'A'
+    if (invertida.getMapeo('A') != 'A' || invertida.getMapeo('Z') != 'B') {
+        std::fprintf(stderr, "cascada invertida: 'A' -> '%c', 'Z' -> '%c' (se esperaba 'A' y 'B')\n",
+                     invertida.getMapeo('A'), invertida.getMapeo('Z'));
+        return false;
+    }
+    
+    std::printf("cascada: composicion correcta\n");
+    return true;
+}
+
+/**
+ * @brief Genera un flujo PRT-7 con la mezcla típica de LOAD/MAP
+ * * Aproximadamente 1 de cada 8 tramas es MAP (rotaciones en [-30, 30]) y
+ * 1 de cada 16 LOAD es un espacio ("L,Space").
+ */
+std::string generarFlujo(int tramas, unsigned long long semilla) {
+    std::string flujo = "SISTEMA PRT-7 ACTIVO\r\n";
+    Aleatorio aleatorio(semilla);
+    char linea[16];
+    
+    for (int i = 0; i < tramas; i++) {
+        unsigned int r = aleatorio.siguiente();
+        
+        if (r % 8 == 0) {
+            std::snprintf(linea, sizeof(linea), "M,%d\r\n", (int)(r / 8 % 61) - 30);
+            flujo += linea;
+        } else if (r % 16 == 1) {
+            flujo += "L,Space\r\n";
+        } else {
+            flujo += "L,";
+            flujo += (char)('A' + r / 16 % 26);
+            flujo += "\r\n";
+        }
+    }
+    
+    flujo += "FIN\r\n";
+    return flujo;
+}
+
+/**
+ * @brief Mensaje que arma decodificarLote() con un flujo completo
+ */
+std::string mensajeDelLote(const std::string& flujo) {
+    ListaDeCarga carga(IMPRESION_SILENCIOSA);
+    RotorDeMapeo rotor;
+    decodificarLote(flujo.data(), flujo.size(), carga, rotor);
+    return carga.aCadena();
+}
+
+/**
+ * @brief DecodificadorPRT7 arma el mismo mensaje que decodificarLote()
+ * * El flujo llega en bloques de tamaño irregular, que cortan las líneas
+ * por la mitad.
+ */
+bool probarAlimentar() {
+    const std::string flujo = generarFlujo(10000, 7);
+    const std::string esperado = mensajeDelLote(flujo);
+    
+    DecodificadorPRT7 decodificador;
+    bool fin = false;
+    size_t pos = 0;
+    Aleatorio aleatorio(3);
+    while (pos < flujo.size()) {
+        int n = 1 + (int)(aleatorio.siguiente() % 97);
+        if ((size_t)n > flujo.size() - pos) n = (int)(flujo.size() - pos);
+        decodificador.alimentar(flujo.data() + pos, n, [&fin](const EventoPRT7& evento) {
+            if (evento.tipo == EVENTO_FIN) fin = true;
+        });
+        pos += (size_t)n;
+    }
+    
+    if (!fin) {
+        std::fprintf(stderr, "alimentar: no se emitio EVENTO_FIN\n");
+        return false;
+    }
+    if (decodificador.getCarga().aCadena() != esperado) {
+        std::fprintf(stderr, "alimentar: el mensaje (%d caracteres) difiere del lote (%d caracteres)\n",
+                     decodificador.getCarga().getTamanio(), (int)esperado.size());
+        return false;
+    }
+    
+    std::printf("alimentar: DecodificadorPRT7 arma el mismo mensaje que el lote\n");
+    return true;
+}
+
+/**
+ * @brief Codifica una trama MAP binaria: código y rotación en varint zigzag
+ * @param conCrc Agrega el CRC-8 al final
+ * @return Longitud de la trama
+ */
+int codificarMapBinario(int rotacion, bool conCrc, char* destino) {
+    unsigned int valor = ((unsigned int)rotacion << 1) ^ (unsigned int)-(int)(rotacion < 0);
+    int longitud = 0;
+    
+    destino[longitud++] = (char)(BINARIO_MAP | (conCrc ? BINARIO_CON_CRC : 0));
+    do {
+        unsigned char byte = (unsigned char)(valor & 0x7F);
+        valor >>= 7;
+        destino[longitud++] = (char)(valor != 0 ? (byte | 0x80) : byte);
+    } while (valor != 0);
+    
+    if (conCrc) {
+        destino[longitud] = (char)crc8(destino, longitud);
+        longitud++;
+    }
+    return longitud;
+}
+
+/**
+ * @brief Mide y analiza una trama binaria y compara con lo esperado
+ * @param longitudEsperada Resultado esperado de medirTramaBinaria()
+ * @param tipoEsperado TRAMA_INVALIDA si analizarTramaBinaria() debe rechazarla
+ */
+bool verificarTramaBinaria(const char* nombre, const char* datos, int longitud, int longitudEsperada,
+                           TipoTrama tipoEsperado, char caracter = '\0', int rotacion = 0) {
+    int medida = medirTramaBinaria(datos, longitud);
+    if (medida != longitudEsperada) {
+        std::fprintf(stderr, "%s: medirTramaBinaria = %d, se esperaba %d\n", nombre, medida, longitudEsperada);
+        return false;
+    }
+    
+    Trama trama;
+    bool valida = analizarTramaBinaria(datos, longitud, trama);
+    if (valida != (tipoEsperado != TRAMA_INVALIDA) || trama.tipo != tipoEsperado) {
+        std::fprintf(stderr, "%s: analizarTramaBinaria = %s con tipo %d, se esperaba tipo %d\n",
+                     nombre, valida ? "true" : "false", (int)trama.tipo, (int)tipoEsperado);
+        return false;
+    }
+    if (tipoEsperado == TRAMA_LOAD && trama.caracter != caracter) {
+        std::fprintf(stderr, "%s: caracter 0x%02X, se esperaba 0x%02X\n",
+                     nombre, (unsigned char)trama.caracter, (unsigned char)caracter);
+        return false;
+    }
+    if (tipoEsperado == TRAMA_MAP && trama.rotacion != rotacion) {
+        std::fprintf(stderr, "%s: rotacion %d, se esperaba %d\n", nombre, trama.rotacion, rotacion);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Formato binario: varint zigzag, CRC-8, códigos inválidos y tramas truncadas
+ */
+bool probarBinario() {
+    // Bytes fijos: el zigzag intercala negativos y positivos (0, -1, 1, -2...)
+    static const char loadA[] = {0x01, 'A'};
+    static const char mapMenosUno[] = {0x02, 0x01};
+    static const char mapUno[] = {0x02, 0x02};
+    static const char mapMenos64[] = {0x02, 0x7F};
+    static const char map64[] = {0x02, (char)0x80, 0x01};
+    static const char fin[] = {0x03};
+    static const char codigoInvalido[] = {0x04, 0x00};
+    static const char varintLargo[] = {0x02, (char)0x80, (char)0x80, (char)0x80, (char)0x80, (char)0x80, 0x01};
+    
+    if (!verificarTramaBinaria("LOAD 'A'", loadA, 2, 2, TRAMA_LOAD, 'A')) return false;
+    if (!verificarTramaBinaria("MAP -1", mapMenosUno, 2, 2, TRAMA_MAP, '\0', -1)) return false;
+    if (!verificarTramaBinaria("MAP 1", mapUno, 2, 2, TRAMA_MAP, '\0', 1)) return false;
+    if (!verificarTramaBinaria("MAP -64", mapMenos64, 2, 2, TRAMA_MAP, '\0', -64)) return false;
+    if (!verificarTramaBinaria("MAP 64", map64, 3, 3, TRAMA_MAP, '\0', 64)) return false;
+    if (!verificarTramaBinaria("FIN", fin, 1, 1, TRAMA_FIN)) return false;
+    if (!verificarTramaBinaria("codigo invalido", codigoInvalido, 2, -1, TRAMA_INVALIDA)) return false;
+    if (!verificarTramaBinaria("varint de 6 bytes", varintLargo, 7, -1, TRAMA_INVALIDA)) return false;
+    
+    // Truncadas: medirTramaBinaria() pide más bytes y analizarTramaBinaria() las rechaza
+    if (!verificarTramaBinaria("LOAD sin caracter", loadA, 1, 0, TRAMA_INVALIDA)) return false;
+    if (!verificarTramaBinaria("MAP sin varint", map64, 1, 0, TRAMA_INVALIDA)) return false;
+    if (!verificarTramaBinaria("MAP con varint a medias", map64, 2, 0, TRAMA_INVALIDA)) return false;
+    if (!verificarTramaBinaria("vacia", fin, 0, 0, TRAMA_INVALIDA)) return false;
+    
+    // Ida y vuelta con y sin CRC, incluyendo los límites de cada largo de varint
+    static const int limites[] = {0, 63, -64, 64, -65, 8191, -8192, 8192, -8193, 1048575, -1048576,
+                                  134217727, -134217728, 134217728, 2147483647, -2147483647 - 1};
+    const int cantidadLimites = (int)(sizeof(limites) / sizeof(limites[0]));
+    Aleatorio aleatorio(18);
+    char trama[MAX_TRAMA_BINARIA + 1];
+    char nombre[64];
+    
+    for (int i = 0; i < cantidadLimites + 20000; i++) {
+        int rotacion = i < cantidadLimites ? limites[i] : (int)aleatorio.siguiente() - (int)aleatorio.siguiente();
+        bool conCrc = (i % 2) == 1;
+        int longitud = codificarMapBinario(rotacion, conCrc, trama);
+        
+        std::snprintf(nombre, sizeof(nombre), "MAP %d%s", rotacion, conCrc ? " con CRC" : "");
+        if (!verificarTramaBinaria(nombre, trama, longitud, longitud, TRAMA_MAP, '\0', rotacion)) return false;
+        if (!verificarTramaBinaria(nombre, trama, longitud - 1, 0, TRAMA_INVALIDA)) return false;
+        
+        if (conCrc) {
+            // Cualquier bit cambiado, en el varint o en el CRC, hace fallar el CRC-8
+            trama[1 + (int)(aleatorio.siguiente() % (unsigned int)(longitud - 1))] ^=
+                (char)(1 << (aleatorio.siguiente() % 7));
+            if (medirTramaBinaria(trama, longitud) == longitud &&
+                !verificarTramaBinaria(nombre, trama, longitud, longitud, TRAMA_INVALIDA)) {
+                return false;
+            }
+        }
+    }
+    
+    // LOAD y FIN con CRC, correcto y alterado
+    char loadConCrc[3] = {(char)(BINARIO_LOAD | BINARIO_CON_CRC), 'Z', 0};
+    loadConCrc[2] = (char)crc8(loadConCrc, 2);
+    char finConCrc[2] = {(char)(BINARIO_FIN | BINARIO_CON_CRC), 0};
+    finConCrc[1] = (char)crc8(finConCrc, 1);
+    if (!verificarTramaBinaria("LOAD con CRC", loadConCrc, 3, 3, TRAMA_LOAD, 'Z')) return false;
+    if (!verificarTramaBinaria("FIN con CRC", finConCrc, 2, 2, TRAMA_FIN)) return false;
+    if (!verificarTramaBinaria("LOAD con CRC truncada", loadConCrc, 2, 0, TRAMA_INVALIDA)) return false;
+    loadConCrc[1] = 'Y';
+    finConCrc[1] ^= 0x01;
+    if (!verificarTramaBinaria("LOAD con CRC que no coincide", loadConCrc, 3, 3, TRAMA_INVALIDA)) return false;
+    if (!verificarTramaBinaria("FIN con CRC que no coincide", finConCrc, 2, 2, TRAMA_INVALIDA)) return false;
+    
+    std::printf("binario: varint zigzag, CRC-8 y tramas truncadas (%d rotaciones)\n", cantidadLimites + 20000);
+    return true;
+}
+
+/**
+ * @brief Compara un campo de EstadisticasLote e informa la diferencia
+ */
+bool mismoCampo(const char* nombre, const char* campo, long long paralelo, long long lote) {
+    if (paralelo == lote) return true;
+    std::fprintf(stderr, "%s: %s = %lld (paralelo) != %lld (lote)\n", nombre, campo, paralelo, lote);
+    return false;
+}
+
+/**
+ * @brief decodificarParalelo() da el mismo mensaje, rotor y estadísticas que decodificarLote()
+ * @param hilos Hilos pedidos a decodificarParalelo()
+ */
+bool verificarParalelo(const char* nombre, const std::string& flujo, int hilos) {
+    ListaDeCarga cargaLote(IMPRESION_SILENCIOSA);
+    ListaDeCarga cargaParalela(IMPRESION_SILENCIOSA);
+    RotorIndexado rotorLote;
+    RotorIndexado rotorParalelo;
+    // El estado inicial del rotor también debe propagarse a todos los tramos
+    rotorLote.rotar(7);
+    rotorParalelo.rotar(7);
+    
+    EstadisticasLote lote = decodificarLote(flujo.data(), flujo.size(), cargaLote, rotorLote);
+    EstadisticasLote paralelo = decodificarParalelo(flujo.data(), flujo.size(), cargaParalela, rotorParalelo,
+                                                    hilos);
+    
+    if (cargaParalela.aCadena() != cargaLote.aCadena()) {
+        std::fprintf(stderr, "%s: el mensaje (%d caracteres) difiere del lote (%d caracteres)\n",
+                     nombre, cargaParalela.getTamanio(), cargaLote.getTamanio());
+        return false;
+    }
+    
+    return mismoCampo(nombre, "desplazamiento", rotorParalelo.getDesplazamiento(),
+                      rotorLote.getDesplazamiento()) &&
+           mismoCampo(nombre, "lineas", paralelo.lineas, lote.lineas) &&
+           mismoCampo(nombre, "tramasLoad", paralelo.tramasLoad, lote.tramasLoad) &&
+           mismoCampo(nombre, "tramasMap", paralelo.tramasMap, lote.tramasMap) &&
+           mismoCampo(nombre, "malformadas", paralelo.malformadas, lote.malformadas) &&
+           mismoCampo(nombre, "control", paralelo.control, lote.control) &&
+           mismoCampo(nombre, "bytesConsumidos", (long long)paralelo.bytesConsumidos,
+                      (long long)lote.bytesConsumidos) &&
+           mismoCampo(nombre, "finEncontrado", paralelo.finEncontrado, lote.finEncontrado);
+}
+
+/**
+ * @brief decodificarParalelo() equivale a decodificarLote()
+ * * Con el FIN en el último tramo, en un tramo del medio (lo que sigue no
+ * debe contar) y sin FIN; con líneas malformadas; y con entradas más cortas
+ * que un tramo, que se decodifican en un solo hilo.
+ */
+bool probarParalelo() {
+    const std::string completo = generarFlujo(200000, 11);
+    std::string finAlMedio = generarFlujo(100000, 13);
+    finAlMedio += generarFlujo(200000, 17);     // Después del FIN: no se decodifica
+    const std::string sinFin = completo.substr(0, completo.size() - 5);
+    std::string malformadas = completo;
+    for (size_t i = 1000; i + 1 < malformadas.size(); i += 7919) {
+        malformadas[i] = '?';
+    }
+    const std::string corto = generarFlujo(1000, 19);
+    
+    if (!verificarParalelo("FIN en el ultimo tramo", completo, 4)) return false;
+    if (!verificarParalelo("FIN en un tramo del medio", finAlMedio, 4)) return false;
+    if (!verificarParalelo("sin FIN", sinFin, 4)) return false;
+    if (!verificarParalelo("lineas malformadas", malformadas, 3)) return false;
+    if (!verificarParalelo("todos los nucleos", completo, 0)) return false;
+    if (!verificarParalelo("mas corto que un tramo", corto, 4)) return false;
+    if (!verificarParalelo("vacio", std::string(), 4)) return false;
+    
+    std::printf("paralelo: decodificarParalelo == decodificarLote (FIN al final, al medio, sin FIN, corto)\n");
+    return true;
+}
+
+/**
+ * @brief Desplazamientos de cada rotor y mensaje, en texto, para comparar estados
+ */
+template <typename Rotor>
+std::string describirEstado(const ListaDeCarga& carga, const Rotor& rotor) {
+    std::string descripcion;
+    char numero[16];
+    for (int k = 0; k < RotoresDe<Rotor>::CANTIDAD; k++) {
+        std::snprintf(numero, sizeof(numero), "%d,", desplazamientoDeRotor(rotor, k));
+        descripcion += numero;
+    }
+    return descripcion + "|" + carga.aCadena();
+}
+
+/**
+ * @brief Restaura un punto de control y compara con el estado esperado
+ * @param esperado describirEstado() del estado que debe quedar
+ */
+template <typename Rotor>
+bool verificarRestauracion(const char* nombre, const std::string& datos, const std::string& esperado,
+                           unsigned long long secuencia, bool binario) {
+    ListaDeCarga carga(IMPRESION_SILENCIOSA);
+    Rotor rotor;
+    EstadoDeFlujo estado;
+    carga.insertarBloque("XYZ", 3);    // Debe reemplazarse, no agregarse
+    rotarRotor(rotor, 0, 3);
+    
+    if (!restaurarPuntoDeControl(datos.data(), (int)datos.size(), carga, rotor, estado)) {
+        std::fprintf(stderr, "%s: restaurarPuntoDeControl rechazo un punto de control valido\n", nombre);
+        return false;
+    }
+    
+    std::string obtenido = describirEstado(carga, rotor);
+    if (obtenido != esperado || estado.secuencia != secuencia || estado.binario != binario) {
+        std::fprintf(stderr, "%s: se restauro [%s] secuencia %llu%s, se esperaba [%s] secuencia %llu%s\n",
+                     nombre, obtenido.c_str(), estado.secuencia, estado.binario ? " binario" : "",
+                     esperado.c_str(), secuencia, binario ? " binario" : "");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief restaurarPuntoDeControl() rechaza los datos y no toca carga, rotor ni estado
+ */
+template <typename Rotor>
+bool verificarRechazo(const char* nombre, const std::string& datos) {
+    ListaDeCarga carga(IMPRESION_SILENCIOSA);
+    Rotor rotor;
+    EstadoDeFlujo estado;
+    carga.insertarBloque("XYZ", 3);
+    rotarRotor(rotor, 0, 3);
+    estado.secuencia = 42;
+    const std::string antes = describirEstado(carga, rotor);
+    
+    if (restaurarPuntoDeControl(datos.data(), (int)datos.size(), carga, rotor, estado)) {
+        std::fprintf(stderr, "%s: restaurarPuntoDeControl acepto un punto de control invalido\n", nombre);
+        return false;
+    }
+    if (describirEstado(carga, rotor) != antes || estado.secuencia != 42) {
+        std::fprintf(stderr, "%s: el rechazo modifico carga, rotor o estado\n", nombre);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Serializa la imagen completa de un punto de control
+ */
+template <typename Rotor>
+std::string imagenDe(const ListaDeCarga& carga, const Rotor& rotor, const EstadoDeFlujo& estado) {
+    std::string datos(tamanioPuntoDeControl<Rotor>(carga), '\0');
+    serializarPuntoDeControl(carga, rotor, estado, &datos[0], (int)datos.size());
+    return datos;
+}
+
+/**
+ * @brief Serializa un registro incremental con los últimos 'nuevos' caracteres
+ */
+template <typename Rotor>
+std::string registroDe(const ListaDeCarga& carga, int nuevos, const Rotor& rotor, const EstadoDeFlujo& estado) {
+    std::string datos(tamanioRegistroPuntoDeControl<Rotor>(nuevos), '\0');
+    serializarRegistroPuntoDeControl(carga, nuevos, rotor, estado, &datos[0], (int)datos.size());
+    return datos;
+}
+
+/**
+ * @brief Ida y vuelta de imagen y registros, y rechazos, para un motor
+ */
+template <typename Rotor>
+bool verificarPuntoDeControl(const char* motor) {
+    const int ROTORES = RotoresDe<Rotor>::CANTIDAD;
+    const int base = ENCABEZADO_PUNTO_DE_CONTROL + 4 * ROTORES;
+    ListaDeCarga carga(IMPRESION_SILENCIOSA);
+    Rotor rotor;
+    EstadoDeFlujo estado;
+    std::string nombre;
+    
+    // Imagen: mensaje con todos los bytes posibles y rotores desplazados
+    for (int c = 0; c < 256; c++) {
+        carga.insertarAlFinal((char)c);
+    }
+    for (int k = 0; k < ROTORES; k++) {
+        rotarRotor(rotor, k, 5 + 7 * k);
+    }
+    estado.secuencia = 123456789012ULL;
+    const std::string imagen = imagenDe(carga, rotor, estado);
+    const std::string estadoImagen = describirEstado(carga, rotor);
+    if (!verificarRestauracion<Rotor>((nombre = std::string(motor) + ", imagen").c_str(), imagen,
+                                      estadoImagen, estado.secuencia, false)) {
+        return false;
+    }
+    
+    // Tres registros: caracteres nuevos, sin caracteres (solo MAP) y paso a modo binario
+    std::string diario = imagen;
+    std::string estados[3];
+    std::string registros[3];
+    
+    carga.insertarBloque("HOLA", 4);
+    rotarRotor(rotor, ROTORES - 1, -3);
+    estado.secuencia += 5;
+    registros[0] = registroDe(carga, 4, rotor, estado);
+    estados[0] = describirEstado(carga, rotor);
+    
+    rotarRotor(rotor, 0, 11);
+    estado.secuencia += 1;
+    registros[1] = registroDe(carga, 0, rotor, estado);
+    estados[1] = describirEstado(carga, rotor);
+    
+    carga.insertarBloque(" MUNDO", 6);
+    estado.secuencia += 6;
+    estado.binario = true;
+    registros[2] = registroDe(carga, 6, rotor, estado);
+    estados[2] = describirEstado(carga, rotor);
+    
+    for (int i = 0; i < 3; i++) {
+        diario += registros[i];
+    }
+    if (!verificarRestauracion<Rotor>((nombre = std::string(motor) + ", imagen y registros").c_str(), diario,
+                                      estados[2], estado.secuencia, true)) {
+        return false;
+    }
+    // La imagen que escribe la compactación restaura lo mismo que imagen + registros
+    if (!verificarRestauracion<Rotor>((nombre = std::string(motor) + ", imagen compactada").c_str(),
+                                      imagenDe(carga, rotor, estado), estados[2], estado.secuencia, true)) {
+        return false;
+    }
+    
+    // Registro incompleto al final: se ignora y queda el estado del anterior
+    const int sinUltimo = (int)(diario.size() - registros[2].size());
+    const int cortes[] = {1, ENCABEZADO_REGISTRO_PC - 1, ENCABEZADO_REGISTRO_PC + 4 * ROTORES,
+                          (int)registros[2].size() - 1};
+    for (int i = 0; i < 4; i++) {
+        nombre = std::string(motor) + ", registro cortado";
+        if (!verificarRestauracion<Rotor>(nombre.c_str(), diario.substr(0, sinUltimo + cortes[i]), estados[1],
+                                          estado.secuencia - 6, false)) {
+            return false;
+        }
+    }
+    
+    // Rechazos
+    std::string malo;
+    if (!verificarRechazo<Rotor>("vacio", std::string())) return false;
+    if (!verificarRechazo<Rotor>("mas corto que el encabezado", imagen.substr(0, base - 1))) return false;
+    malo = imagen;
+    malo[0] = 'X';
+    if (!verificarRechazo<Rotor>("firma", malo)) return false;
+    malo = imagen;
+    escribirU16(&malo[4], VERSION_PUNTO_DE_CONTROL + 1);
+    if (!verificarRechazo<Rotor>("version", malo)) return false;
+    malo = imagen;
+    escribirU32(&malo[16], (unsigned long)rotor.getTamanio() + 1);
+    if (!verificarRechazo<Rotor>("otro alfabeto", malo)) return false;
+    malo = imagen;
+    escribirU32(&malo[20], (unsigned long)ROTORES + 1);
+    if (!verificarRechazo<Rotor>("otra cantidad de rotores", malo)) return false;
+    malo = imagen;
+    escribirU32(&malo[24], 0xFFFFFFFCUL);
+    if (!verificarRechazo<Rotor>("largo del mensaje enorme", malo)) return false;
+    if (!verificarRechazo<Rotor>("mensaje cortado", imagen.substr(0, imagen.size() - 1))) return false;
+    malo = imagen;
+    escribirU32(&malo[ENCABEZADO_PUNTO_DE_CONTROL + 4 * (ROTORES - 1)], (unsigned long)rotor.getTamanio());
+    if (!verificarRechazo<Rotor>("desplazamiento fuera del alfabeto", malo)) return false;
+    malo = diario;
+    malo[imagen.size() + registros[0].size()] = 'X';
+    if (!verificarRechazo<Rotor>("registro con firma invalida", malo)) return false;
+    malo = diario;
+    escribirU32(&malo[imagen.size() + ENCABEZADO_REGISTRO_PC], (unsigned long)rotor.getTamanio());
+    if (!verificarRechazo<Rotor>("registro con desplazamiento fuera del alfabeto", malo)) return false;
+    
+    // Buffers chicos y registros más largos que el mensaje
+    std::string chico(tamanioRegistroPuntoDeControl<Rotor>(4) - 1, '\0');
+    if (serializarPuntoDeControl(carga, rotor, estado, &chico[0], (int)chico.size()) != -1 ||
+        serializarRegistroPuntoDeControl(carga, 4, rotor, estado, &chico[0], (int)chico.size()) != -1) {
+        std::fprintf(stderr, "%s: se serializo en un buffer de %d bytes\n", motor, (int)chico.size());
+        return false;
+    }
+    std::string grande(tamanioRegistroPuntoDeControl<Rotor>(carga.getTamanio() + 1), '\0');
+    if (serializarRegistroPuntoDeControl(carga, carga.getTamanio() + 1, rotor, estado, &grande[0],
+                                         (int)grande.size()) != -1) {
+        std::fprintf(stderr, "%s: se serializo un registro mas largo que el mensaje\n", motor);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Puntos de control: ida y vuelta, registros incrementales y rechazos
+ * * Con un rotor simple, una cascada y un alfabeto distinto; un punto de
+ * control de un motor no se acepta en otro.
+ */
+bool probarPuntoDeControl() {
+    if (!verificarPuntoDeControl<RotorIndexado>("indexado")) return false;
+    if (!verificarPuntoDeControl<CascadaDeRotores<AlfabetoMayusculas, 3> >("cascada")) return false;
+    if (!verificarPuntoDeControl<RotorAlfanumerico>("alfanumerico")) return false;
+    
+    ListaDeCarga carga(IMPRESION_SILENCIOSA);
+    carga.insertarBloque("ABC", 3);
+    EstadoDeFlujo estado;
+    const std::string deIndexado = imagenDe(carga, RotorIndexado(), estado);
+    if (!verificarRechazo<RotorAlfanumerico>("imagen de otro alfabeto", deIndexado)) return false;
+    if (!verificarRechazo<CascadaDeRotores<AlfabetoMayusculas, 3> >("imagen de un solo rotor", deIndexado)) {
+        return false;
+    }
+    
+    std::printf("punto de control: ida y vuelta, registros incrementales y rechazos\n");
+    return true;
+}
+
+#ifdef PRT7_CORRUTINAS
+const bool CORRUTINAS_DISPONIBLES = true;
+
+/**
+ * @brief decodificarDescriptor() arma el mismo mensaje que decodificarLote()
+ *        leyendo el flujo de una tubería
+ */
+bool probarCorrutinas() {
+    const std::string flujo = generarFlujo(10000, 7);
+    int tubo[2];
+    if (pipe(tubo) != 0) {
+        std::perror("corrutinas: pipe");
+        return false;
+    }
+    
+    std::thread escritor([&flujo, &tubo]() {
+        size_t enviados = 0;
+        while (enviados < flujo.size()) {
+            ssize_t n = write(tubo[1], flujo.data() + enviados, flujo.size() - enviados);
+            if (n <= 0) break;
+            enviados += (size_t)n;
+        }
+        close(tubo[1]);
+    });
+    
+    BucleDeLectura bucle;
+    DecodificadorPRT7 decodificador;
+    bool fin = false;
+    decodificarDescriptor(bucle, tubo[0], decodificador, [&fin](const EventoPRT7& evento) {
+        if (evento.tipo == EVENTO_FIN) fin = true;
+    });
+    bool ejecutado = bucle.ejecutar();
+    escritor.join();
+    close(tubo[0]);
+    
+    if (!ejecutado || !fin) {
+        std::fprintf(stderr, "corrutinas: el bucle %s y %s EVENTO_FIN\n",
+                     ejecutado ? "termino" : "fallo", fin ? "se emitio" : "no se emitio");
+        return false;
+    }
+    if (decodificador.getCarga().aCadena() != mensajeDelLote(flujo)) {
+        std::fprintf(stderr, "corrutinas: el mensaje difiere del lote\n");
+        return false;
+    }
+    
+    std::printf("corrutinas: decodificarDescriptor arma el mismo mensaje que el lote\n");
+    return true;
+}
+#else
+const bool CORRUTINAS_DISPONIBLES = false;
+
+bool probarCorrutinas() {
+    return true;
+}
+#endif
+
+/**
+ * @brief Código de salida que ctest informa como prueba omitida (SKIP_RETURN_CODE)
+ */
+const int PRUEBA_OMITIDA = 77;
+
+struct Prueba {
+    const char* nombre;
+    bool (*funcion)();
+    bool disponible;        ///< false: esta compilación no la soporta
+};
+
+const Prueba PRUEBAS[] = {
+    {"rotores", probarRotores, true},
+    {"lote", probarLote, true},
+    {"alfabetos", probarAlfabetos, true},
+    {"cascada", probarCascada, true},
+    {"alimentar", probarAlimentar, true},
+    {"paralelo", probarParalelo, true},
+    {"binario", probarBinario, true},
+    {"punto_de_control", probarPuntoDeControl, true},
+    {"corrutinas", probarCorrutinas, CORRUTINAS_DISPONIBLES},
+};
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const int cantidad = (int)(sizeof(PRUEBAS) / sizeof(PRUEBAS[0]));
+    const char* pedida = argc > 1 ? argv[1] : nullptr;
+    int corridas = 0;
+    int omitidas = 0;
+    int fallidas = 0;
+    
+    for (int i = 0; i < cantidad; i++) {
+        if (pedida != nullptr && !sonIguales(pedida, PRUEBAS[i].nombre)) continue;
+        
+        if (!PRUEBAS[i].disponible) {
+            std::printf("%s: no disponible en esta compilacion, se omite\n", PRUEBAS[i].nombre);
+            omitidas++;
+            continue;
+        }
+        
+        corridas++;
+        if (!PRUEBAS[i].funcion()) {
+            std::fprintf(stderr, "FALLO: %s\n", PRUEBAS[i].nombre);
+            fallidas++;
+        }
+    }
+    
+    if (corridas == 0 && omitidas > 0) return PRUEBA_OMITIDA;
+    if (corridas == 0) {
+        std::fprintf(stderr, "Prueba desconocida: %s\n", pedida);
+        return 1;
+    }
+    
+    return fallidas == 0 ? 0 : 1;
+}
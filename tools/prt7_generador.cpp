@@ -0,0 +1,889 @@
+/**
+ * @file prt7_generador.cpp
+ * @brief Generador de tráfico PRT-7 sintético y prueba de resistencia
+ * @author Sistema de Ciberseguridad Industrial
+ * @date 2025
+ * * Emite ciclos PRT-7 (tramas LOAD/MAP/FIN) con la mezcla, la tasa y la
+ * cantidad pedidas, a un archivo, a la salida estándar o a un puerto serial
+ * virtual (pty). Cada ciclo se decodifica al generarse con el mismo
+ * RotorDeMapeo del decodificador, así que también se puede escribir el
+ * mensaje que debería ensamblarse (--esperado).
+ *
+ * Con --soak <decodificador> lanza decodificador_prt7 en modo continuo
+ * sobre un pty, lo alimenta durante --duracion segundos y compara cada
+ * mensaje que imprime con el esperado; al final informa ciclos y
+ * caracteres perdidos, tasa sostenida y crecimiento de memoria (VmRSS).
+ * La prueba falla (código 1) si algún ciclo no llegó o llegó distinto.
+ *
+ * Ejemplos:
+ *   prt7_generador --salida captura.txt --ciclos 100 --esperado mensajes.txt
+ *   prt7_generador --pty --enlace /tmp/ttyPRT7 --tasa 2000 --malformadas 5
+ *   prt7_generador --soak ./decodificador_prt7 --duracion 60 --tasa 50000 -- --tuberia
+ */
+
+#include "decodificador_prt7.h"
+
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#ifndef _WIN32
+    #include <cerrno>
+    #include <fcntl.h>
+    #include <poll.h>
+    #include <sys/wait.h>
+    #include <termios.h>
+    #include <unistd.h>
+#endif
+
+namespace {
+
+/**
+ * @brief Lo pone en 1 SIGINT/SIGTERM: se deja de generar y se cierra en orden
+ */
+volatile std::sig_atomic_t detener = 0;
+
+void pedirDetencion(int) {
+    detener = 1;
+}
+
+/**
+ * @brief Generador congruencial lineal determinista
+ */
+struct Aleatorio {
+    unsigned long long estado;
+    
+    Aleatorio(unsigned long long semilla) : estado(semilla) {}
+    
+    unsigned int siguiente() {
+        estado = estado * 6364136223846793005ULL + 1442695040888963407ULL;
+        return (unsigned int)(estado >> 33);
+    }
+};
+
+/**
+ * @brief Mezcla de tramas de cada ciclo
+ */
+struct OpcionesTrafico {
+    int tramasPorCiclo;         ///< Tramas LOAD/MAP/malformadas antes de cada FIN
+    int porcentajeMap;          ///< Porcentaje de tramas MAP
+    int porcentajeEspacios;     ///< Porcentaje de tramas "L,Space"
+    int porcentajeMalformadas;  ///< Porcentaje de líneas que el decodificador debe descartar
+    int rotacionMaxima;         ///< Las MAP rotan en [-rotacionMaxima, rotacionMaxima]
+    unsigned long long semilla;
+    
+    OpcionesTrafico()
+        : tramasPorCiclo(64), porcentajeMap(12), porcentajeEspacios(6), porcentajeMalformadas(0),
+          rotacionMaxima(30), semilla(1) {}
+};
+
+/**
+ * @brief Arma ciclos PRT-7 y el mensaje que cada uno debe producir
+ */
+class GeneradorDeTrafico {
+private:
+    OpcionesTrafico opciones;
+    Aleatorio aleatorio;
+    RotorDeMapeo rotor;     // Sigue al del decodificador para calcular el mensaje
+    long long tramas;
+    long long malformadas;
+
+public:
+    GeneradorDeTrafico(const OpcionesTrafico& o)
+        : opciones(o), aleatorio(o.semilla), tramas(0), malformadas(0) {}
+    
+    long long getTramas() const {
+        return tramas;
+    }
+    
+    long long getMalformadas() const {
+        return malformadas;
+    }
+    
+    /**
+     * @brief Agrega el saludo con el que arranca el sketch de arduino.txt
+     */
+    void saludo(std::string& salida) {
+        salida += TEXTO_SALUDO;
+        salida += "\r\n";
+    }
+    
+    /**
+     * @brief Agrega un ciclo completo, terminado en FIN
+     * @param salida Recibe las líneas del ciclo
+     * @param esperado Recibe el mensaje que el decodificador debe ensamblar
+     */
+    void generarCiclo(std::string& salida, std::string& esperado) {
+        // El decodificador en modo continuo reinicia el rotor en cada FIN
+        rotor.reiniciar();
+        esperado.clear();
+        
+        const int hastaMap = opciones.porcentajeMalformadas + opciones.porcentajeMap;
+        const int hastaEspacios = hastaMap + opciones.porcentajeEspacios;
+        
+        for (int i = 0; i < opciones.tramasPorCiclo; i++) {
+            int r = (int)(aleatorio.siguiente() % 100);
+            
+            if (r < opciones.porcentajeMalformadas) {
+                agregarMalformada(salida);
+            } else if (r < hastaMap) {
+                agregarMap(salida);
+            } else if (r < hastaEspacios) {
+                agregarLoad(salida, esperado, true);
+            } else {
+                agregarLoad(salida, esperado, false);
+            }
+        }
+        
+        salida += TEXTO_FIN;
+        salida += "\r\n";
+    }
+
+private:
+    static bool separaLineas(char c) {
+        return c == '\n' || c == '\r';
+    }
+    
+    void agregarLoad(std::string& salida, std::string& esperado, bool espacio) {
+        char decodificado = rotor.getMapeo(' ');
+        
+        if (!espacio || separaLineas(decodificado)) {
+            // Una letra cuyo mapeo no corte la línea del mensaje impreso
+            char letra;
+            do {
+                letra = (char)('A' + aleatorio.siguiente() % 26);
+                decodificado = rotor.getMapeo(letra);
+            } while (separaLineas(decodificado));
+            
+            salida += "L,";
+            salida += letra;
+            salida += "\r\n";
+        } else {
+            salida += "L,Space\r\n";
+        }
+        
+        esperado += decodificado;
+        tramas++;
+    }
+    
+    void agregarMap(std::string& salida) {
+        int rango = 2 * opciones.rotacionMaxima + 1;
+        int n = (int)(aleatorio.siguiente() % (unsigned int)rango) - opciones.rotacionMaxima;
+        char linea[32];
+        
+        if (RotoresDe<RotorDeMapeo>::CANTIDAD > 1) {
+            int destino = (int)(aleatorio.siguiente() % RotoresDe<RotorDeMapeo>::CANTIDAD);
+            std::snprintf(linea, sizeof(linea), "M,%d,%d\r\n", n, destino + 1);
+            rotarRotor(rotor, destino, n);
+        } else {
+            std::snprintf(linea, sizeof(linea), "M,%d\r\n", n);
+            rotor.rotar(n);
+        }
+        
+        salida += linea;
+        tramas++;
+    }
+    
+    void agregarMalformada(std::string& salida) {
+        static const char* const PLANTILLAS[] = {"X,%d", "L", "M", "M%d", "Q,%c", "LOAD,%c", "#%d!", "l,%c"};
+        const int CANTIDAD = sizeof(PLANTILLAS) / sizeof(PLANTILLAS[0]);
+        char linea[32];
+        Trama trama;
+        
+        do {
+            unsigned int r = aleatorio.siguiente();
+            const char* plantilla = PLANTILLAS[r % CANTIDAD];
+            if (std::strstr(plantilla, "%c") != nullptr) {
+                std::snprintf(linea, sizeof(linea), plantilla, 'A' + (int)(r / CANTIDAD % 26));
+            } else {
+                std::snprintf(linea, sizeof(linea), plantilla, (int)(r / CANTIDAD % 1000));
+            }
+        } while (clasificarLinea(linea, (int)std::strlen(linea), trama) != TRAMA_INVALIDA);
+        
+        salida += linea;
+        salida += "\r\n";
+        malformadas++;
+    }
+};
+
+/**
+ * @brief Adonde va el tráfico generado
+ */
+class DestinoDeTrafico {
+public:
+    virtual ~DestinoDeTrafico() {}
+    
+    /**
+     * @return false si el destino dejó de aceptar datos
+     */
+    virtual bool escribir(const char* datos, size_t n) = 0;
+};
+
+/**
+ * @brief Archivo o salida estándar
+ */
+class DestinoArchivo : public DestinoDeTrafico {
+private:
+    std::FILE* archivo;
+    
+public:
+    DestinoArchivo(std::FILE* a) : archivo(a) {}
+    
+    bool escribir(const char* datos, size_t n) override {
+        return std::fwrite(datos, 1, n, archivo) == n && std::fflush(archivo) == 0;
+    }
+};
+
+#ifndef _WIN32
+
+/**
+ * @brief Lado maestro de un pty
+ * * Si nadie lee el esclavo, write() se bloquearía para siempre; por eso
+ * escribe sin bloquearse, espera con poll() en tramos cortos y, si sigue
+ * sin lugar, atiende SIGINT y revisa si el proceso del otro lado (el
+ * decodificador del soak) terminó.
+ */
+class DestinoPty : public DestinoDeTrafico {
+private:
+    int maestro;
+    pid_t vigilado;     // -1: nadie a quien vigilar
+    bool terminado;
+    int estado;         // De waitpid(), una vez terminado el vigilado
+    
+public:
+    DestinoPty(int m, pid_t v = -1) : maestro(m), vigilado(v), terminado(false), estado(0) {
+        // Un write() bloqueante a una tty espera a escribir todo, aunque poll() diga que hay lugar
+        fcntl(maestro, F_SETFL, fcntl(maestro, F_GETFL) | O_NONBLOCK);
+    }
+    
+    /**
+     * @brief Indica si el proceso vigilado terminó y con qué estado
+     * * Solo es confiable después de que escribir() haya fallado o de
+     * cerrar el maestro; esperarVigilado() lo espera.
+     */
+    bool vigiladoTerminado(int& e) const {
+        e = estado;
+        return terminado;
+    }
+    
+    /**
+     * @brief Espera a que termine el proceso vigilado
+     */
+    void esperarVigilado() {
+        while (vigilado > 0 && !terminado) {
+            if (waitpid(vigilado, &estado, 0) == vigilado || errno != EINTR) terminado = true;
+        }
+    }
+    
+    bool escribir(const char* datos, size_t n) override {
+        while (n > 0) {
+            struct pollfd espera;
+            espera.fd = maestro;
+            espera.events = POLLOUT;
+            espera.revents = 0;
+            
+            int listo = poll(&espera, 1, 200);
+            if (listo < 0 && errno != EINTR) return false;
+            
+            if (listo > 0 && (espera.revents & POLLOUT) == 0) {
+                return false;   // POLLHUP: ya nadie tiene abierto el esclavo
+            }
+            if (listo <= 0) {
+                // Nadie lee: con Ctrl+C se abandona el ciclo a medias
+                if (detener) return false;
+                // ¿Sigue vivo el del otro lado?
+                if (vigilado > 0 && !terminado && waitpid(vigilado, &estado, WNOHANG) == vigilado) {
+                    terminado = true;
+                }
+                if (terminado) return false;
+                continue;
+            }
+            
+            ssize_t escritos = write(maestro, datos, n);
+            if (escritos < 0) {
+                if (errno == EINTR || errno == EAGAIN) continue;
+                return false;
+            }
+            datos += escritos;
+            n -= (size_t)escritos;
+        }
+        return true;
+    }
+};
+
+#endif // _WIN32
+
+/**
+ * @brief Escribe líneas respetando una tasa de tramas por segundo
+ * * Acumula las líneas que ya deberían haberse enviado y duerme solo
+ * cuando va adelantado, así que a tasas altas escribe en bloques grandes.
+ */
+class Emisor {
+private:
+    DestinoDeTrafico& destino;
+    long long tasa;     // Tramas por segundo; 0 = sin límite
+    std::chrono::steady_clock::time_point inicio;
+    long long lineas;
+    bool fallo;
+
+public:
+    Emisor(DestinoDeTrafico& d, long long t)
+        : destino(d), tasa(t), inicio(std::chrono::steady_clock::now()), lineas(0), fallo(false) {}
+    
+    long long getLineas() const {
+        return lineas;
+    }
+    
+    bool fallado() const {
+        return fallo;
+    }
+    
+    /**
+     * @brief Envía un bloque de líneas completas
+     * @return false si el destino dejó de aceptar datos
+     */
+    bool enviar(const std::string& bloque) {
+        const char* datos = bloque.data();
+        size_t desde = 0;
+        
+        for (size_t i = 0; i < bloque.size() && tasa > 0; i++) {
+            if (bloque[i] != '\n') continue;
+            lineas++;
+            
+            std::chrono::steady_clock::time_point debido =
+                inicio + std::chrono::nanoseconds(lineas * 1000000000LL / tasa);
+            if (debido > std::chrono::steady_clock::now()) {
+                if (!escribir(datos + desde, i + 1 - desde)) return false;
+                desde = i + 1;
+                std::this_thread::sleep_until(debido);
+            }
+        }
+        if (tasa <= 0) {
+            for (size_t i = 0; i < bloque.size(); i++) {
+                if (bloque[i] == '\n') lineas++;
+            }
+        }
+        
+        return escribir(datos + desde, bloque.size() - desde);
+    }
+
+private:
+    bool escribir(const char* datos, size_t n) {
+        if (n == 0) return true;
+        if (!destino.escribir(datos, n)) {
+            fallo = true;
+        }
+        return !fallo;
+    }
+};
+
+/**
+ * @brief Segundos transcurridos desde un instante
+ */
+double segundosDesde(std::chrono::steady_clock::time_point inicio) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
+}
+
+/**
+ * @brief Genera ciclos hacia un destino hasta agotar ciclos o duración
+ * @param ciclos Ciclos a emitir; negativo = sin límite
+ * @param duracion Segundos máximos; 0 = sin límite
+ * @param esperado Archivo para los mensajes esperados, uno por línea, o nullptr
+ * @return Código de salida del proceso
+ */
+int generar(DestinoDeTrafico& destino, const OpcionesTrafico& opciones, long long tasa, long long ciclos,
+            int duracion, std::FILE* esperado) {
+    GeneradorDeTrafico generador(opciones);
+    Emisor emisor(destino, tasa);
+    std::chrono::steady_clock::time_point inicio = std::chrono::steady_clock::now();
+    std::string bloque;
+    std::string mensaje;
+    long long emitidos = 0;
+    
+    generador.saludo(bloque);
+    
+    while (!detener && (ciclos < 0 || emitidos < ciclos) &&
+           (duracion <= 0 || segundosDesde(inicio) < duracion)) {
+        generador.generarCiclo(bloque, mensaje);
+        if (!emisor.enviar(bloque)) break;
+        bloque.clear();
+        emitidos++;
+        
+        if (esperado != nullptr) {
+            std::fwrite(mensaje.data(), 1, mensaje.size(), esperado);
+            std::fputc('\n', esperado);
+        }
+    }
+    
+    double segundos = segundosDesde(inicio);
+    std::fprintf(stderr, "Generados %lld ciclos, %lld tramas (%lld malformadas) en %.2f s (%.0f lineas/s)\n",
+                 emitidos, generador.getTramas(), generador.getMalformadas(), segundos,
+                 segundos > 0 ? emisor.getLineas() / segundos : 0.0);
+    
+    if (emisor.fallado() && !detener) {
+        std::fprintf(stderr, "ERROR: El destino dejo de aceptar datos.\n");
+        return 1;
+    }
+    return 0;
+}
+
+#ifndef _WIN32
+
+/**
+ * @brief Abre un pty en modo crudo
+ * @param esclavo Recibe el descriptor del lado esclavo (el "puerto serial")
+ * @param ruta Recibe la ruta del esclavo (p. ej. /dev/pts/3)
+ * @return Descriptor del lado maestro, o -1
+ */
+int abrirPty(int& esclavo, char* ruta, size_t capacidad) {
+    int maestro = posix_openpt(O_RDWR | O_NOCTTY);
+    if (maestro < 0) return -1;
+    
+    if (grantpt(maestro) != 0 || unlockpt(maestro) != 0 || ptsname(maestro) == nullptr) {
+        close(maestro);
+        return -1;
+    }
+    std::snprintf(ruta, capacidad, "%s", ptsname(maestro));
+    
+    // Abrir el esclavo crudo antes de escribir: si no, la disciplina de
+    // línea convertiría los '\r' y devolvería eco al maestro
+    esclavo = open(ruta, O_RDWR | O_NOCTTY);
+    if (esclavo < 0) {
+        close(maestro);
+        return -1;
+    }
+    struct termios opciones;
+    tcgetattr(esclavo, &opciones);
+    cfmakeraw(&opciones);
+    tcsetattr(esclavo, TCSANOW, &opciones);
+    
+    return maestro;
+}
+
+/**
+ * @brief Memoria residente de un proceso en KiB (solo Linux)
+ * @return -1 si no se puede consultar
+ */
+long leerMemoriaResidente(pid_t pid) {
+    #ifdef __linux__
+        char ruta[64];
+        std::snprintf(ruta, sizeof(ruta), "/proc/%d/status", (int)pid);
+        std::FILE* archivo = std::fopen(ruta, "r");
+        if (archivo == nullptr) return -1;
+        
+        char linea[256];
+        long kib = -1;
+        while (std::fgets(linea, sizeof(linea), archivo) != nullptr) {
+            if (std::strncmp(linea, "VmRSS:", 6) == 0) {
+                kib = std::strtol(linea + 6, nullptr, 10);
+                break;
+            }
+        }
+        std::fclose(archivo);
+        return kib;
+    #else
+        (void)pid;
+        return -1;
+    #endif
+}
+
+/**
+ * @brief Compara los mensajes que imprime el decodificador con los esperados
+ * * El hilo de lectura de la salida del decodificador llama a recibir();
+ * el hilo que genera, a esperar() antes de enviar cada ciclo.
+ */
+class ComparadorDeMensajes {
+private:
+    std::mutex candado;
+    std::deque<std::string> pendientes;
+    long long enviados;
+    long long recibidos;
+    long long distintos;
+    long long sobrantes;        // Mensajes que no corresponden a ningún ciclo enviado
+    long long caracteresEsperados;
+    long long caracteresRecibidos;
+
+public:
+    ComparadorDeMensajes()
+        : enviados(0), recibidos(0), distintos(0), sobrantes(0), caracteresEsperados(0),
+          caracteresRecibidos(0) {}
+    
+    void esperar(const std::string& mensaje) {
+        std::lock_guard<std::mutex> guardia(candado);
+        pendientes.push_back(mensaje);
+        enviados++;
+        caracteresEsperados += (long long)mensaje.size();
+    }
+    
+    void recibir(const char* mensaje, size_t longitud) {
+        std::lock_guard<std::mutex> guardia(candado);
+        caracteresRecibidos += (long long)longitud;
+        
+        if (pendientes.empty()) {
+            sobrantes++;
+            return;
+        }
+        recibidos++;
+        if (pendientes.front().size() != longitud ||
+            std::memcmp(pendientes.front().data(), mensaje, longitud) != 0) {
+            distintos++;
+        }
+        pendientes.pop_front();
+    }
+    
+    long long faltantes() {
+        std::lock_guard<std::mutex> guardia(candado);
+        return enviados - recibidos;
+    }
+    
+    /**
+     * @return true si todos los ciclos llegaron exactos
+     */
+    bool informar() {
+        std::lock_guard<std::mutex> guardia(candado);
+        long long perdidos = caracteresEsperados - caracteresRecibidos;
+        
+        std::printf("Ciclos: %lld enviados, %lld recibidos, %lld distintos, %lld sin recibir\n",
+                    enviados, recibidos, distintos, enviados - recibidos);
+        std::printf("Caracteres: %lld esperados, %lld recibidos (%lld tramas LOAD perdidas)\n",
+                    caracteresEsperados, caracteresRecibidos, perdidos > 0 ? perdidos : 0);
+        if (sobrantes > 0) {
+            std::printf("Mensajes inesperados: %lld\n", sobrantes);
+        }
+        return distintos == 0 && sobrantes == 0 && enviados == recibidos;
+    }
+};
+
+/**
+ * @brief Lee la salida del decodificador línea por línea hasta que la cierre
+ */
+void leerMensajes(int descriptor, ComparadorDeMensajes& comparador) {
+    std::string linea;
+    char bloque[4096];
+    ssize_t n;
+    
+    while ((n = read(descriptor, bloque, sizeof(bloque))) != 0) {
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        for (ssize_t i = 0; i < n; i++) {
+            if (bloque[i] == '\n') {
+                comparador.recibir(linea.data(), linea.size());
+                linea.clear();
+            } else {
+                linea += bloque[i];
+            }
+        }
+    }
+}
+
+/**
+ * @brief Prueba de resistencia: decodificador_prt7 --continuo bajo carga sostenida
+ * @param decodificador Ruta del ejecutable
+ * @param extra Opciones adicionales para el decodificador (las que siguen a "--")
+ * @param cantidadExtra Cantidad de opciones en extra
+ * @param esperaMs Tiempo para que el decodificador abra el puerto antes de enviar
+ * @return 0 si todos los ciclos llegaron exactos
+ */
+int ejecutarSoak(const char* decodificador, char** extra, int cantidadExtra, const OpcionesTrafico& opciones,
+                 long long tasa, long long ciclos, int duracion, int esperaMs) {
+    int esclavo;
+    char rutaEsclavo[128];
+    int maestro = abrirPty(esclavo, rutaEsclavo, sizeof(rutaEsclavo));
+    if (maestro < 0) {
+        std::fprintf(stderr, "ERROR: No se pudo abrir un pty.\n");
+        return 1;
+    }
+    
+    int tuberia[2];
+    if (pipe(tuberia) != 0) {
+        std::fprintf(stderr, "ERROR: No se pudo crear la tuberia.\n");
+        return 1;
+    }
+    
+    pid_t pid = fork();
+    if (pid < 0) {
+        std::fprintf(stderr, "ERROR: No se pudo lanzar %s.\n", decodificador);
+        return 1;
+    }
+    if (pid == 0) {
+        // Proceso hijo: el decodificador imprime un mensaje por ciclo en la tubería
+        dup2(tuberia[1], STDOUT_FILENO);
+        close(tuberia[0]);
+        close(tuberia[1]);
+        close(maestro);
+        close(esclavo);
+        // Ctrl+C solo detiene al generador; el decodificador termina al cerrarse el pty
+        std::signal(SIGINT, SIG_IGN);
+        
+        const int FIJOS = 7;
+        char** argumentos = new char*[FIJOS + cantidadExtra + 1];
+        argumentos[0] = const_cast<char*>(decodificador);
+        argumentos[1] = const_cast<char*>("--puerto");
+        argumentos[2] = rutaEsclavo;
+        argumentos[3] = const_cast<char*>("--continuo");
+        argumentos[4] = const_cast<char*>("--verbosidad");
+        argumentos[5] = const_cast<char*>("silencio");
+        argumentos[6] = const_cast<char*>("--stats");
+        for (int i = 0; i < cantidadExtra; i++) {
+            argumentos[FIJOS + i] = extra[i];
+        }
+        argumentos[FIJOS + cantidadExtra] = nullptr;
+        
+        execv(decodificador, argumentos);
+        std::fprintf(stderr, "ERROR: No se pudo ejecutar %s.\n", decodificador);
+        _exit(127);
+    }
+    close(tuberia[1]);
+    
+    ComparadorDeMensajes comparador;
+    std::thread lector(leerMensajes, tuberia[0], std::ref(comparador));
+    
+    // Dar tiempo a que el decodificador abra el puerto; después el esclavo
+    // queda solo en sus manos
+    std::this_thread::sleep_for(std::chrono::milliseconds(esperaMs));
+    close(esclavo);
+    
+    DestinoPty destino(maestro, pid);
+    GeneradorDeTrafico generador(opciones);
+    Emisor emisor(destino, tasa);
+    std::chrono::steady_clock::time_point inicio = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point ultimaMuestra = inicio;
+    long memoriaInicial = -1;
+    long memoriaMaxima = -1;
+    std::string bloque;
+    std::string mensaje;
+    long long emitidos = 0;
+    
+    std::printf("Prueba de resistencia: %s en %s (%s, %d tramas por ciclo)\n", decodificador, rutaEsclavo,
+                tasa > 0 ? "tasa limitada" : "maxima tasa", opciones.tramasPorCiclo);
+    std::fflush(stdout);
+    
+    generador.saludo(bloque);
+    while (!detener && (ciclos < 0 || emitidos < ciclos) &&
+           (duracion <= 0 || segundosDesde(inicio) < duracion)) {
+        generador.generarCiclo(bloque, mensaje);
+        comparador.esperar(mensaje);
+        if (!emisor.enviar(bloque)) break;
+        bloque.clear();
+        emitidos++;
+        
+        // Una muestra de memoria por segundo; la primera sirve de referencia
+        if (segundosDesde(ultimaMuestra) >= 1.0) {
+            ultimaMuestra = std::chrono::steady_clock::now();
+            long kib = leerMemoriaResidente(pid);
+            if (memoriaInicial < 0) memoriaInicial = kib;
+            if (kib > memoriaMaxima) memoriaMaxima = kib;
+        }
+    }
+    double segundos = segundosDesde(inicio);
+    
+    // Esperar a que se impriman los últimos ciclos (mientras sigan llegando)
+    long long faltantes = comparador.faltantes();
+    for (int intentos = 0; faltantes > 0 && intentos < 20 && !emisor.fallado(); intentos++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        long long ahora = comparador.faltantes();
+        if (ahora < faltantes) intentos = 0;
+        faltantes = ahora;
+    }
+    long memoriaFinal = leerMemoriaResidente(pid);
+    if (memoriaFinal > memoriaMaxima) memoriaMaxima = memoriaFinal;
+    if (memoriaInicial < 0) memoriaInicial = memoriaFinal;
+    
+    // Cerrar el maestro desconecta el puerto: el decodificador termina solo
+    close(maestro);
+    destino.esperarVigilado();
+    int estado;
+    destino.vigiladoTerminado(estado);
+    lector.join();
+    close(tuberia[0]);
+    
+    std::printf("---\n");
+    std::printf("Tramas: %lld LOAD/MAP, %lld malformadas en %.2f s\n", generador.getTramas(),
+                generador.getMalformadas(), segundos);
+    std::printf("Tasa sostenida: %.0f lineas/s\n", segundos > 0 ? emisor.getLineas() / segundos : 0.0);
+    bool exacto = comparador.informar();
+    if (memoriaFinal >= 0) {
+        std::printf("Memoria del decodificador (VmRSS): %ld KiB al primer segundo, %ld KiB al final, "
+                    "%ld KiB maximo (%+ld KiB)\n",
+                    memoriaInicial, memoriaFinal, memoriaMaxima, memoriaFinal - memoriaInicial);
+    } else {
+        std::printf("Memoria del decodificador: no disponible\n");
+    }
+    
+    if (emisor.fallado() && !detener) {
+        std::printf("El decodificador cerro el puerto antes de tiempo.\n");
+        exacto = false;
+    }
+    if (!WIFEXITED(estado) || WEXITSTATUS(estado) != 0) {
+        std::printf("El decodificador termino con estado %d.\n",
+                    WIFEXITED(estado) ? WEXITSTATUS(estado) : -1);
+        exacto = false;
+    }
+    std::printf("Resultado: %s\n", exacto ? "OK" : "FALLO");
+    return exacto ? 0 : 1;
+}
+
+#endif // _WIN32
+
+void imprimirUso(const char* programa) {
+    std::fprintf(stderr,
+                 "Uso: %s [--salida <ruta | -> [--esperado <ruta>] | --pty [--enlace <ruta>]"
+                 " | --soak <decodificador> [--espera <ms>]]\n"
+                 "       [--tasa <tramas/s>] [--ciclos <n>] [--duracion <s>] [--tramas <n>]"
+                 " [--map <%%>] [--espacios <%%>] [--malformadas <%%>]\n"
+                 "       [--rotacion-max <n>] [--semilla <n>] [-- <opciones del decodificador>]\n",
+                 programa);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    OpcionesTrafico opciones;
+    const char* rutaSalida = nullptr;
+    const char* rutaEsperado = nullptr;
+    const char* decodificador = nullptr;
+    const char* enlace = nullptr;
+    bool pty = false;
+    long long tasa = 0;
+    long long ciclos = -1;
+    int duracion = 0;
+    int esperaMs = 300;
+    char** extra = nullptr;
+    int cantidadExtra = 0;
+    
+    std::signal(SIGINT, pedirDetencion);
+    std::signal(SIGTERM, pedirDetencion);
+    
+    for (int i = 1; i < argc; i++) {
+        const char* valor = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        int entero = valor ? aEntero(valor, (int)std::strlen(valor)) : 0;
+        
+        if (sonIguales(argv[i], "--")) {
+            extra = argv + i + 1;
+            cantidadExtra = argc - i - 1;
+            break;
+        } else if (sonIguales(argv[i], "--pty")) {
+            pty = true;
+            continue;
+        } else if (valor == nullptr) {
+            imprimirUso(argv[0]);
+            return 1;
+        }
+        
+        if (sonIguales(argv[i], "--salida")) {
+            rutaSalida = valor;
+        } else if (sonIguales(argv[i], "--esperado")) {
+            rutaEsperado = valor;
+        } else if (sonIguales(argv[i], "--enlace")) {
+            enlace = valor;
+        } else if (sonIguales(argv[i], "--soak")) {
+            decodificador = valor;
+        } else if (sonIguales(argv[i], "--espera")) {
+            esperaMs = entero;
+        } else if (sonIguales(argv[i], "--tasa")) {
+            tasa = entero;
+        } else if (sonIguales(argv[i], "--ciclos")) {
+            ciclos = entero;
+        } else if (sonIguales(argv[i], "--duracion")) {
+            duracion = entero;
+        } else if (sonIguales(argv[i], "--tramas")) {
+            opciones.tramasPorCiclo = entero;
+        } else if (sonIguales(argv[i], "--map")) {
+            opciones.porcentajeMap = entero;
+        } else if (sonIguales(argv[i], "--espacios")) {
+            opciones.porcentajeEspacios = entero;
+        } else if (sonIguales(argv[i], "--malformadas")) {
+            opciones.porcentajeMalformadas = entero;
+        } else if (sonIguales(argv[i], "--rotacion-max")) {
+            opciones.rotacionMaxima = entero;
+        } else if (sonIguales(argv[i], "--semilla")) {
+            opciones.semilla = std::strtoull(valor, nullptr, 10);
+        } else {
+            std::fprintf(stderr, "Opcion desconocida: %s\n", argv[i]);
+            imprimirUso(argv[0]);
+            return 1;
+        }
+        i++;
+    }
+    
+    if (opciones.porcentajeMap < 0 || opciones.porcentajeEspacios < 0 || opciones.porcentajeMalformadas < 0 ||
+        opciones.porcentajeMap + opciones.porcentajeEspacios + opciones.porcentajeMalformadas > 100) {
+        std::fprintf(stderr, "ERROR: Los porcentajes deben ser positivos y sumar como maximo 100.\n");
+        return 1;
+    }
+    if (opciones.tramasPorCiclo < 0 || opciones.rotacionMaxima < 0 || opciones.rotacionMaxima > 1000000000 ||
+        tasa < 0 || duracion < 0 || esperaMs < 0) {
+        std::fprintf(stderr, "ERROR: Valor invalido.\n");
+        return 1;
+    }
+    if ((rutaSalida != nullptr) + pty + (decodificador != nullptr) != 1) {
+        imprimirUso(argv[0]);
+        return 1;
+    }
+    
+    if (rutaSalida != nullptr) {
+        bool estandar = sonIguales(rutaSalida, "-");
+        std::FILE* destino = estandar ? stdout : std::fopen(rutaSalida, "wb");
+        std::FILE* esperado = rutaEsperado ? std::fopen(rutaEsperado, "wb") : nullptr;
+        if (destino == nullptr || (rutaEsperado != nullptr && esperado == nullptr)) {
+            std::fprintf(stderr, "ERROR: No se pudo abrir %s.\n",
+                         destino == nullptr ? rutaSalida : rutaEsperado);
+            return 1;
+        }
+        
+        DestinoArchivo archivo(destino);
+        int codigo = generar(archivo, opciones, tasa, ciclos < 0 && duracion == 0 ? 1 : ciclos, duracion,
+                             esperado);
+        if (!estandar) std::fclose(destino);
+        if (esperado != nullptr) std::fclose(esperado);
+        return codigo;
+    }
+    
+    #ifdef _WIN32
+        (void)enlace;
+        (void)esperaMs;
+        (void)extra;
+        (void)cantidadExtra;
+        std::fprintf(stderr, "ERROR: --pty y --soak no estan disponibles en Windows.\n");
+        return 1;
+    #else
+        if (decodificador != nullptr) {
+            return ejecutarSoak(decodificador, extra, cantidadExtra, opciones, tasa, ciclos,
+                                ciclos < 0 && duracion == 0 ? 10 : duracion, esperaMs);
+        }
+        
+        int esclavo;
+        char rutaEsclavo[128];
+        int maestro = abrirPty(esclavo, rutaEsclavo, sizeof(rutaEsclavo));
+        if (maestro < 0) {
+            std::fprintf(stderr, "ERROR: No se pudo abrir un pty.\n");
+            return 1;
+        }
+        if (enlace != nullptr) {
+            unlink(enlace);
+            if (symlink(rutaEsclavo, enlace) != 0) {
+                std::fprintf(stderr, "ERROR: No se pudo crear el enlace %s.\n", enlace);
+                return 1;
+            }
+        }
+        std::fprintf(stderr, "Puerto virtual: %s%s%s\n", rutaEsclavo,
+                     enlace ? " -> " : "", enlace ? enlace : "");
+        
+        // El esclavo queda abierto: el decodificador puede conectarse y
+        // reconectarse sin perder el pty
+        DestinoPty destino(maestro);
+        int codigo = generar(destino, opciones, tasa, ciclos, duracion, nullptr);
+        close(maestro);
+        close(esclavo);
+        if (enlace != nullptr) unlink(enlace);
+        return codigo;
+    #endif
+}